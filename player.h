@@ -20,6 +20,246 @@ extern "C" {
 
 typedef struct PlayerSession PlayerSession;
 typedef struct PlayerSettings PlayerSettings;
+typedef struct PlayerCreateRequest PlayerCreateRequest;
+
+/// @brief 播放统计信息
+typedef struct PlayerStats {
+    /// @brief 当前解码器跳帧等级（0 为不跳过）
+    int video_skip_level;
+    /// @brief 因跳帧而未发送给解码器的视频数据包数
+    uint64_t video_skipped_decodes;
+    /// @brief 已解码但因播放落后而丢弃的视频帧数
+    uint64_t video_dropped_frames;
+    /// @brief 同一帧再次显示的次数（帧的时长跨过多次刷新）
+    uint64_t video_repeated_frames;
+    /// @brief 测量到的延迟：最近读取的数据包到当前播放位置的时间（单位：微秒）
+    int64_t latency;
+    /// @brief 低延迟模式下因延迟过大而丢弃的音频样本数
+    uint64_t live_dropped_samples;
+    /// @brief 视频数据包缓冲区中数据的时长（单位：微秒）
+    int64_t video_buffered_packets_duration;
+    /// @brief 视频数据包缓冲区中数据的字节数
+    int64_t video_buffered_packets_size;
+    /// @brief 已解码等待显示的视频帧数
+    uint64_t video_buffered_frames;
+    /// @brief 直接转换到纹理中（不经过中间帧），每帧节省的内存读写字节数
+    int64_t video_bytes_saved_per_frame;
+    /// @brief 直接转换到纹理中，总共节省的内存读写字节数
+    uint64_t video_bytes_saved;
+    /// @brief 混音器处理该会话的累计耗时（单位：微秒，仅使用共享音频输出时统计）
+    int64_t audio_mix_time;
+    /// @brief 混音器处理该会话的次数
+    uint64_t audio_mix_calls;
+    /// @brief 当前的音频缓冲区大小（单位 ms，使用自适应缓冲区时会变化）
+    uint32_t audio_buffer_size;
+    /// @brief 当前的视频数据包缓冲区大小（单位 ms）
+    uint32_t video_buffer_size;
+    /// @brief 音频回调时缓冲区数据不足的次数
+    uint64_t audio_underruns;
+    /// @brief 需要显示视频时没有已解码帧的次数
+    uint64_t video_stalls;
+    /// @brief 自适应缓冲区调整大小的次数
+    uint64_t buffer_adjustments;
+    /// @brief 解码线程从等待中被唤醒的次数（缓冲区已满或暂停时不应增加）
+    uint64_t decode_wakeups;
+    /// @brief 事件线程从等待中被唤醒的次数（只在有窗口消息或退出时增加）
+    uint64_t event_wakeups;
+} PlayerStats;
+
+/// @brief 因音频数据不足增大缓冲区
+#define PLAYER_BUFFER_GROW_UNDERRUN 0
+/// @brief 因视频解码跟不上增大缓冲区
+#define PLAYER_BUFFER_GROW_STALL 1
+/// @brief 长时间没有卡顿，缩小缓冲区
+#define PLAYER_BUFFER_SHRINK 2
+/// @brief 保留的最近缓冲区调整记录数量
+#define PLAYER_BUFFER_ADJUSTMENT_LOG_SIZE 32
+
+/// @brief 一次自适应缓冲区大小的调整记录
+typedef struct PlayerBufferAdjustment {
+    /// @brief 调整的时间（av_gettime_relative，单位：微秒）
+    int64_t time;
+    /// @brief 调整原因（PLAYER_BUFFER_*）
+    int reason;
+    /// @brief 调整前后的大小（单位 ms）
+    uint32_t old_size;
+    uint32_t new_size;
+    /// @brief 调整时累计的卡顿次数
+    uint64_t audio_underruns;
+    uint64_t video_stalls;
+} PlayerBufferAdjustment;
+
+/// @brief 打开文件并探测流信息
+#define PLAYER_INIT_OPEN_INPUT 0
+/// @brief 选择音频和视频流
+#define PLAYER_INIT_FIND_STREAMS 1
+/// @brief 初始化 SDL 子系统
+#define PLAYER_INIT_SDL 2
+/// @brief 打开音频解码器和滤镜
+#define PLAYER_INIT_AUDIO_DECODER 3
+/// @brief 打开视频解码器和滤镜
+#define PLAYER_INIT_VIDEO_DECODER 4
+/// @brief 打开音频设备（或加入混音器）
+#define PLAYER_INIT_AUDIO_OUTPUT 5
+/// @brief 分配视频缓冲区，指定窗口时还包括初始化渲染器
+#define PLAYER_INIT_VIDEO_OUTPUT 6
+#define PLAYER_INIT_STEP_COUNT 7
+
+/// @brief 一个初始化步骤的耗时
+typedef struct PlayerInitStep {
+    /// @brief 相对于开始创建的时间（单位：微秒）
+    int64_t start;
+    /// @brief 耗时（单位：微秒），未执行的步骤为0
+    int64_t duration;
+} PlayerInitStep;
+
+/// @brief 创建会话时各步骤的耗时，部分步骤同时进行，总耗时小于各步骤之和
+typedef struct PlayerInitStats {
+    /// @brief 按 PLAYER_INIT_* 索引
+    PlayerInitStep steps[PLAYER_INIT_STEP_COUNT];
+    /// @brief 创建会话的总耗时（单位：微秒）
+    int64_t total;
+} PlayerInitStats;
+
+/// @brief 解码线程
+#define PLAYER_THREAD_DECODE 0
+/// @brief 事件处理和视频显示线程
+#define PLAYER_THREAD_EVENT 1
+#define PLAYER_THREAD_COUNT 2
+/// @brief 默认优先级
+#define PLAYER_THREAD_PRIORITY_DEFAULT 0
+/// @brief 提高线程优先级（THREAD_PRIORITY_HIGHEST）
+#define PLAYER_THREAD_PRIORITY_HIGH 1
+/// @brief 注册到多媒体类调度服务（MMCSS），不可用时退回到 PLAYER_THREAD_PRIORITY_HIGH
+#define PLAYER_THREAD_PRIORITY_REALTIME 2
+
+/// @brief 线程实际应用的调度设置
+typedef struct PlayerThreadInfo {
+    /// @brief 请求的优先级（PLAYER_THREAD_PRIORITY_*）
+    int requested_priority;
+    /// @brief 实际应用的优先级（PLAYER_THREAD_PRIORITY_*）
+    int applied_priority;
+    /// @brief 系统报告的线程优先级（GetThreadPriority）
+    int os_priority;
+    /// @brief 请求的和实际应用的 CPU 亲和性掩码，0 为未设置
+    uint64_t requested_affinity;
+    uint64_t applied_affinity;
+    /// @brief 亲和性掩码所在的处理器组
+    int processor_group;
+    /// @brief 实际绑定的 NUMA 节点，-1 为未绑定
+    int numa_node;
+    /// @brief 最近一次失败的系统错误码（GetLastError），0 为全部成功
+    unsigned long error;
+} PlayerThreadInfo;
+
+/// @brief 共享音频输出（混音器）的统计信息
+typedef struct PlayerMixerStats {
+    /// @brief 当前加入混音器的会话数
+    int sessions;
+    /// @brief 设备格式，混音器未打开时为0
+    int sample_rate;
+    int channels;
+    /// @brief 设备回调次数
+    uint64_t callbacks;
+    /// @brief 混音的累计耗时（单位：微秒）
+    int64_t total_time;
+    /// @brief 最近一次回调的混音耗时（单位：微秒）
+    int64_t last_time;
+} PlayerMixerStats;
+
+/// @brief 帧间隔直方图的大小
+#define PLAYER_PACING_HISTOGRAM_SIZE 8
+/// @brief 保留的最近显示记录数量
+#define PLAYER_PRESENTATION_LOG_SIZE 256
+
+/// @brief 视频帧显示节奏统计
+typedef struct PlayerPacingStats {
+    /// @brief 已显示的不同帧数
+    uint64_t presented_frames;
+    /// @brief 比预期的垂直同步晚显示的周期数（仅开启垂直同步时统计）
+    uint64_t missed_vsyncs;
+    /// @brief 垂直同步周期（单位：微秒）
+    int64_t vsync_interval;
+    /// @brief 最近一次显示新帧的时间（av_gettime）
+    int64_t last_present_time;
+    /// @brief 帧间隔直方图：第 i 项为与上一帧间隔 i 个垂直同步周期的帧数，最后一项包含更长的间隔
+    uint64_t interval_histogram[PLAYER_PACING_HISTOGRAM_SIZE];
+} PlayerPacingStats;
+
+/// @brief 一帧视频的显示记录
+typedef struct PlayerPresentation {
+    /// @brief 帧的时间戳（相对于第一帧，单位：微秒）
+    int64_t pts;
+    /// @brief 实际显示的时间（av_gettime，单位：微秒）
+    int64_t present_time;
+} PlayerPresentation;
+
+/// @brief 离线渲染结果
+typedef struct PlayerRenderResult {
+    /// @brief 输出的音频样本数
+    uint64_t audio_samples;
+    /// @brief 输出的视频帧数
+    uint64_t video_frames;
+    /// @brief 重复输出的视频帧数
+    uint64_t duplicated_frames;
+    /// @brief 丢弃的视频帧数
+    uint64_t dropped_frames;
+    /// @brief 输出的时长（单位：微秒）
+    int64_t duration;
+    /// @brief 实际耗时（单位：微秒），与 duration 相比即为处理速度
+    int64_t elapsed;
+} PlayerRenderResult;
+
+/// @brief 流信息
+typedef struct PlayerStreamInfo {
+    /// @brief 流序号
+    int index;
+    /// @brief 流类型（PLAYER_MEDIA_TYPE_*）
+    int type;
+    /// @brief 解码器名称，没有可用的解码器时为空字符串
+    char codec[32];
+    /// @brief 语言（来自 language 元数据）
+    char language[16];
+    /// @brief 标题（来自 title 元数据）
+    char title[128];
+    /// @brief 音频声道数
+    int channels;
+    /// @brief 音频采样率
+    int sample_rate;
+    /// @brief 视频宽度
+    int width;
+    /// @brief 视频高度
+    int height;
+    /// @brief 比特率（可能为0）
+    int64_t bit_rate;
+    /// @brief 是否为默认流
+    unsigned char is_default;
+    /// @brief 是否正在使用
+    unsigned char is_selected;
+    /// @brief 是否为附加图片（如音乐文件的封面），只在没有其他视频流时作为封面显示
+    unsigned char is_attached_pic;
+} PlayerStreamInfo;
+
+/**
+ * @brief 缩略图回调
+ * @param userdata 用户数据
+ * @param url 缩略图所属的文件
+ * @param index 缩略图序号
+ * @param pts 缩略图对应的时间（单位：微秒），未知时为 INT64_MIN
+ * @param rgba RGBA 格式的图像数据，仅在回调期间有效
+ * @param linesize 每行的字节数
+ * @param width 图像宽度
+ * @param height 图像高度
+ * @return 返回非0值停止提取该文件剩余的缩略图
+*/
+typedef int (*PlayerThumbnailCallback)(void* userdata, const char* url, int index, int64_t pts, const uint8_t* rgba, int linesize, int width, int height);
+/**
+ * @brief 异步创建完成的回调，在后台线程中调用
+ * @param userdata 用户数据
+ * @param session 创建的会话，失败或取消时为NULL，需要调用 player_free 释放
+ * @param err 错误代码，取消时为 PLAYER_ERR_CANCELLED
+*/
+typedef void (*PlayerCreateCallback)(void* userdata, PlayerSession* session, int err);
 
 #ifndef BUILD_PLAYER
 #define AV_LOG_QUIET    -8
@@ -33,6 +273,28 @@ typedef struct PlayerSettings PlayerSettings;
 #define AV_LOG_TRACE    56
 #endif
 
+/// 允许音频设备使用不同的采样率
+#define PLAYER_AUDIO_ALLOW_FREQUENCY_CHANGE 0x1
+/// 允许音频设备使用不同的样本格式（设备选择无法直接输出的格式时仍由 SDL 转换）
+#define PLAYER_AUDIO_ALLOW_FORMAT_CHANGE 0x2
+/// 允许音频设备使用不同的声道数
+#define PLAYER_AUDIO_ALLOW_CHANNELS_CHANGE 0x4
+/// 允许音频设备使用不同的回调样本数
+#define PLAYER_AUDIO_ALLOW_SAMPLES_CHANGE 0x8
+#define PLAYER_AUDIO_ALLOW_ANY_CHANGE 0xF
+
+#define PLAYER_MEDIA_TYPE_UNKNOWN -1
+#define PLAYER_MEDIA_TYPE_VIDEO 0
+#define PLAYER_MEDIA_TYPE_AUDIO 1
+#define PLAYER_MEDIA_TYPE_DATA 2
+#define PLAYER_MEDIA_TYPE_SUBTITLE 3
+#define PLAYER_MEDIA_TYPE_ATTACHMENT 4
+
+/// 自动选择第一个可以解码的流
+#define PLAYER_STREAM_AUTO -1
+/// 不使用该类型的流
+#define PLAYER_STREAM_DISABLED -2
+
 #define PLAYER_ERR_OK 0
 #define PLAYER_ERR_NULLPTR 1
 #define PLAYER_ERR_SDL 2
@@ -43,6 +305,14 @@ typedef struct PlayerSettings PlayerSettings;
 #define PLAYER_ERR_WAIT_MUTEX_FAILED 7
 #define PLAYER_ERR_FAILED_CREATE_THREAD 8
 #define PLAYER_ERR_NO_DURATION 9
+#define PLAYER_ERR_NEXT_ITEM_PENDING 10
+#define PLAYER_ERR_INCOMPATIBLE_NEXT_ITEM 11
+#define PLAYER_ERR_OPEN_FILE 12
+#define PLAYER_ERR_INVALID_STREAM 13
+#define PLAYER_ERR_TOO_MANY_SESSIONS 14
+#define PLAYER_ERR_CANCELLED 15
+#define PLAYER_ERR_FAILED_CREATE_EVENT 16
+#define PLAYER_ERR_INVALID_ARGUMENT 17
 
 PLAYER_API const char* player_version_str();
 PLAYER_API int32_t player_version();
@@ -98,6 +368,30 @@ PLAYER_API int player_create(const char* url, PlayerSession** session);
  * @return 错误代码
 */
 PLAYER_API int player_create2(const char* url, PlayerSession** session, PlayerSettings* settings);
+/**
+ * @brief 在后台线程中创建播放器会话，立即返回
+ *
+ * 打开文件、探测、打开解码器和初始化输出都在后台线程中进行，完成后调用 callback（无论成功、失败或取消都只调用一次）。
+ * @param url 要播放的文件路径
+ * @param settings 播放器设置，如果为NULL会使用默认设置。需要保持有效直到回调返回，成功时还需要在会话销毁前保持有效。
+ * @param callback 完成时的回调
+ * @param userdata 传给回调的用户数据
+ * @param request 用于接收请求指针的指针，需要调用 player_free_create_request 释放
+ * @return 错误代码
+*/
+PLAYER_API int player_create_async(const char* url, PlayerSettings* settings, PlayerCreateCallback callback, void* userdata, PlayerCreateRequest** request);
+/**
+ * @brief 取消异步创建，正在进行的读取会立即中断，回调会收到 PLAYER_ERR_CANCELLED
+ *
+ * 回调已经调用后取消没有效果。
+ * @param request 请求指针
+*/
+PLAYER_API void player_cancel_create(PlayerCreateRequest* request);
+/**
+ * @brief 释放异步创建请求，尚未完成时会先取消并等待回调返回（不能在回调中调用）
+ * @param request 请求指针的指针
+*/
+PLAYER_API void player_free_create_request(PlayerCreateRequest** request);
 /**
  * @brief 等待播放器初始化完成
  * @param session 播放器会话指针
@@ -141,6 +435,171 @@ PLAYER_API int player_is_playing(PlayerSession* session);
 */
 PLAYER_API int player_get_duration(PlayerSession* session, int64_t* duration);
 PLAYER_API void player_free(PlayerSession** session);
+/**
+ * @brief 设置下一个要播放的文件
+ *
+ * 会在后台线程中打开文件并初始化解码器。当前文件解码完毕后会无缝切换到下一个文件，
+ * 音频设备和窗口会被复用。下一个文件需要包含与当前文件相同类型的流。
+ * @param session 播放器会话指针
+ * @param url 下一个文件的路径
+ * @return 错误代码，如果已经设置了下一个文件且尚未切换，返回 PLAYER_ERR_NEXT_ITEM_PENDING
+*/
+PLAYER_API int player_enqueue_next(PlayerSession* session, const char* url);
+/**
+ * @brief 在现有会话中打开另一个文件，替换当前文件
+ *
+ * 保留线程、窗口、渲染器和音频设备（新文件的音频会转换到已打开的设备格式），
+ * 解码参数相同时还会保留解码器，只替换 demuxer，比重新创建会话快得多。
+ * 新文件需要包含当前会话使用的音频/视频流，否则返回 PLAYER_ERR_INCOMPATIBLE_NEXT_ITEM，
+ * 此时需要用 player_create2 重新创建会话。
+ * 打开后会话处于暂停状态，需要调用 player_play 开始播放。失败时保留原来的文件。
+ * @param session 播放器会话指针
+ * @param url 文件路径
+ * @return 错误代码
+*/
+PLAYER_API int player_open(PlayerSession* session, const char* url);
+/**
+ * @brief 判断是否有等待切换的下一个文件
+ * @param session 播放器会话指针
+ * @return 是否有等待切换的下一个文件
+*/
+PLAYER_API int player_has_next(PlayerSession* session);
+/**
+ * @brief 获取当前正在解码的文件序号
+ * @param session 播放器会话指针
+ * @return 文件序号（第一个文件为0，每切换一次加1）
+*/
+PLAYER_API uint64_t player_get_item_index(PlayerSession* session);
+/**
+ * @brief 获取播放统计信息
+ * @param session 播放器会话指针
+ * @param stats 用于接收统计信息的指针
+ * @return 错误代码
+*/
+PLAYER_API int player_get_stats(PlayerSession* session, PlayerStats* stats);
+/**
+ * @brief 获取文件中流的数量
+ * @param session 播放器会话指针
+ * @return 流的数量
+*/
+PLAYER_API int player_get_stream_count(PlayerSession* session);
+/**
+ * @brief 获取视频帧显示节奏统计
+ * @param session 播放器会话指针
+ * @param stats 用于接收统计信息的指针
+ * @return 错误代码
+*/
+PLAYER_API int player_get_pacing_stats(PlayerSession* session, PlayerPacingStats* stats);
+/**
+ * @brief 清空视频帧显示节奏统计和显示记录
+ * @param session 播放器会话指针
+*/
+PLAYER_API void player_reset_pacing_stats(PlayerSession* session);
+/**
+ * @brief 获取最近显示的帧的显示记录，按显示顺序排列
+ * @param session 播放器会话指针
+ * @param entries 用于接收记录的数组
+ * @param max 数组大小，最多返回 PLAYER_PRESENTATION_LOG_SIZE 条
+ * @return 返回的记录数
+*/
+PLAYER_API int player_get_presentations(PlayerSession* session, PlayerPresentation* entries, int max);
+/**
+ * @brief 获取最近的自适应缓冲区调整记录，按时间顺序排列
+ * @param session 播放器会话指针
+ * @param entries 用于接收记录的数组
+ * @param max 数组大小，最多返回 PLAYER_BUFFER_ADJUSTMENT_LOG_SIZE 条
+ * @return 返回的记录数
+*/
+PLAYER_API int player_get_buffer_adjustments(PlayerSession* session, PlayerBufferAdjustment* entries, int max);
+/**
+ * @brief 获取创建会话时各步骤的耗时
+ * @param session 播放器会话指针
+ * @param stats 用于接收统计信息的指针
+ * @return 错误代码
+*/
+PLAYER_API int player_get_init_stats(PlayerSession* session, PlayerInitStats* stats);
+/**
+ * @brief 获取探测缓存的命中和未命中次数（所有会话共享）
+ * @param hits 用于接收命中次数的指针（可为NULL）
+ * @param misses 用于接收未命中次数的指针（可为NULL）
+*/
+PLAYER_API void player_get_probe_cache_stats(uint64_t* hits, uint64_t* misses);
+/**
+ * @brief 设置会话在混音器中的音量，音量变化在一个设备周期内渐变（仅使用共享音频输出时生效）
+ * @param session 播放器会话指针
+ * @param gain 音量（0.0 - 4.0），默认 1.0
+ * @return 错误代码
+*/
+PLAYER_API int player_set_gain(PlayerSession* session, float gain);
+/**
+ * @brief 设置会话是否静音（仅使用共享音频输出时生效）
+ * @param session 播放器会话指针
+ * @param mute 是否静音
+ * @return 错误代码
+*/
+PLAYER_API int player_set_mute(PlayerSession* session, unsigned char mute);
+/**
+ * @brief 设置会话是否独奏，有会话独奏时只输出独奏的会话（仅使用共享音频输出时生效）
+ * @param session 播放器会话指针
+ * @param solo 是否独奏
+ * @return 错误代码
+*/
+PLAYER_API int player_set_solo(PlayerSession* session, unsigned char solo);
+/**
+ * @brief 获取共享音频输出（混音器）的统计信息
+ * @param stats 用于接收统计信息的指针
+ * @return 错误代码
+*/
+PLAYER_API int player_get_mixer_stats(PlayerMixerStats* stats);
+/**
+ * @brief 获取线程实际应用的调度设置，线程尚未启动或不存在时返回全0
+ * @param session 播放器会话指针
+ * @param thread PLAYER_THREAD_*
+ * @param info 用于接收信息的指针
+ * @return 错误代码
+*/
+PLAYER_API int player_get_thread_info(PlayerSession* session, int thread, PlayerThreadInfo* info);
+/**
+ * @brief 开始记录各处理步骤（读取、解码、重采样、缩放、上传纹理、显示、音频回调）的耗时
+ *
+ * 对所有会话生效，之前记录的事件会被丢弃。每个线程保留最近 16384 个事件。
+*/
+PLAYER_API void player_trace_start();
+/// @brief 停止记录
+PLAYER_API void player_trace_stop();
+/**
+ * @brief 将记录的事件导出为 Chrome / Perfetto 可以打开的 JSON 文件（chrome://tracing 或 ui.perfetto.dev）
+ *
+ * 最好在 player_trace_stop 之后调用，否则正在写入的事件可能不完整。
+ * @param path 文件路径
+ * @return 错误代码
+*/
+PLAYER_API int player_trace_dump(const char* path);
+/**
+ * @brief 获取流信息
+ * @param session 播放器会话指针
+ * @param index 流序号
+ * @param info 用于接收流信息的指针
+ * @return 错误代码
+*/
+PLAYER_API int player_get_stream_info(PlayerSession* session, int index, PlayerStreamInfo* info);
+/**
+ * @brief 播放时切换音轨，不需要重新打开文件
+ *
+ * 会在解码线程中切换，已经缓冲的旧音轨数据会继续播放。
+ * @param session 播放器会话指针
+ * @param index 音频流序号
+ * @return 错误代码
+*/
+PLAYER_API int player_select_audio_stream(PlayerSession* session, int index);
+/**
+ * @brief 获取音频设备缓冲区的延迟，音视频同步时会扣除这部分延迟
+ * @note 按 SDL 缓冲和设备缓冲各一个周期估算，不含系统混音器的缓冲，是实际延迟的下限
+ * @param session 播放器会话指针
+ * @param latency 用于接收延迟的指针（单位：微秒）
+ * @return 错误代码
+*/
+PLAYER_API int player_get_audio_device_latency(PlayerSession* session, int64_t* latency);
 
 /**
  * @brief 初始化播放器设置，会自动设置为默认值
@@ -166,18 +625,228 @@ PLAYER_API void player_settings_set_resize(PlayerSettings* settings, unsigned ch
 PLAYER_API void player_settings_set_audio_buffer_size(PlayerSettings* settings, uint32_t size);
 /**
  * @brief 设置视频缓冲区大小
+ *
+ * 视频以未解码的数据包缓冲，只有少量帧会提前解码（见 player_settings_set_video_frame_lookahead）。
  * @param settings 播放器设置指针
- * @param size 视频缓冲区大小（单位 ms）
+ * @param size 视频缓冲区大小（单位 ms），默认 1000
 */
 PLAYER_API void player_settings_set_video_buffer_size(PlayerSettings* settings, uint32_t size);
+/**
+ * @brief 设置视频缓冲区的最大字节数，与时长限制先达到者为准
+ * @param settings 播放器设置指针
+ * @param bytes 最大字节数，默认 32 MiB
+*/
+PLAYER_API void player_settings_set_video_buffer_bytes(PlayerSettings* settings, uint32_t bytes);
+/**
+ * @brief 设置自适应缓冲区
+ *
+ * 启用后音频和视频缓冲区从最小值开始（更快开始播放），出现音频数据不足或视频解码跟不上时加倍，
+ * 持续 30 秒没有卡顿后缩小 1/4，始终保持在最小值和最大值之间。启用后不再使用
+ * player_settings_set_audio_buffer_size 和 player_settings_set_video_buffer_size 设置的大小，低延迟模式下不生效。
+ * 调整记录可通过 player_get_buffer_adjustments 获取。
+ * @param settings 播放器设置指针
+ * @param min 最小大小（单位 ms）
+ * @param max 最大大小（单位 ms），为0时禁用
+ * @return 错误代码
+*/
+PLAYER_API int player_settings_set_adaptive_buffer(PlayerSettings* settings, uint32_t min, uint32_t max);
+/**
+ * @brief 设置预先解码的视频帧数
+ * @param settings 播放器设置指针
+ * @param frames 帧数，最少为 2，默认 4（低延迟模式下按目标延迟计算）
+*/
+PLAYER_API void player_settings_set_video_frame_lookahead(PlayerSettings* settings, uint32_t frames);
 /**
  * @brief 设置窗口句柄
  * @param settings 播放器设置指针
  * @param hWnd 指向窗口句柄的指针
 */
 PLAYER_API void player_settings_set_hWnd(PlayerSettings* settings, void** hWnd);
+/**
+ * @brief 设置播放落后时是否让解码器跳过部分解码工作（默认开启）
+ * @param settings 播放器设置指针
+ * @param enable 是否开启
+*/
+PLAYER_API void player_settings_set_frame_skip(PlayerSettings* settings, unsigned char enable);
+/**
+ * @brief 设置是否启用低延迟模式（用于直播流、摄像头等）
+ *
+ * 启用后会禁用探测缓冲、使用低延迟解码，缓冲区大小使用目标延迟，不等待缓冲区填满，
+ * 并在延迟增大时稍微加速或丢弃数据来追赶。
+ * @param settings 播放器设置指针
+ * @param enable 是否启用
+*/
+PLAYER_API void player_settings_set_low_latency(PlayerSettings* settings, unsigned char enable);
+/**
+ * @brief 设置低延迟模式下的目标延迟
+ * @param settings 播放器设置指针
+ * @param latency 目标延迟（单位 ms），默认 50
+*/
+PLAYER_API void player_settings_set_target_latency(PlayerSettings* settings, uint32_t latency);
+/**
+ * @brief 指定输入格式（例如 lavfi、dshow），会复制传入的字符串
+ * @param settings 播放器设置指针
+ * @param format 输入格式名称，为NULL时自动检测
+ * @return 错误代码
+*/
+PLAYER_API int player_settings_set_input_format(PlayerSettings* settings, const char* format);
+/**
+ * @brief 设置音频滤镜，会在解码线程中处理，会复制传入的字符串
+ * @param settings 播放器设置指针
+ * @param filter FFmpeg 滤镜描述（如 "volume=0.5"），为NULL时不使用
+ * @return 错误代码
+*/
+PLAYER_API int player_settings_set_audio_filter(PlayerSettings* settings, const char* filter);
+/**
+ * @brief 设置视频滤镜，会在解码线程中处理，会复制传入的字符串
+ * @param settings 播放器设置指针
+ * @param filter FFmpeg 滤镜描述（如 "yadif"、"scale=1280:-2"），为NULL时不使用
+ * @return 错误代码
+*/
+PLAYER_API int player_settings_set_video_filter(PlayerSettings* settings, const char* filter);
+/**
+ * @brief 设置播放速度，音频使用 atempo 保持音调不变
+ * @param settings 播放器设置指针
+ * @param speed 播放速度，会限制在 0.5 - 4.0 之间
+*/
+PLAYER_API void player_settings_set_speed(PlayerSettings* settings, double speed);
+/**
+ * @brief 设置音频设备每次回调的样本数，越小延迟越低但唤醒越频繁
+ * @param settings 播放器设置指针
+ * @param samples 样本数，为0时使用 10ms 对应的样本数
+*/
+PLAYER_API void player_settings_set_audio_period(PlayerSettings* settings, uint16_t samples);
+/**
+ * @brief 设置使用的音频设备，会复制传入的字符串
+ * @param settings 播放器设置指针
+ * @param device 设备名称（与 SDL_GetAudioDeviceName 一致），为NULL时使用默认设备
+ * @return 错误代码
+*/
+PLAYER_API int player_settings_set_audio_device(PlayerSettings* settings, const char* device);
+/**
+ * @brief 设置允许音频设备使用与请求不同的格式，避免 SDL 额外转换
+ * @param settings 播放器设置指针
+ * @param allowed_changes PLAYER_AUDIO_ALLOW_* 的组合
+*/
+PLAYER_API void player_settings_set_audio_allowed_changes(PlayerSettings* settings, int allowed_changes);
+/**
+ * @brief 指定使用的音频流，未使用的流会在 demux 时直接丢弃
+ *
+ * 对播放列表中的后续文件同样生效。
+ * @param settings 播放器设置指针
+ * @param index 流序号，PLAYER_STREAM_AUTO 为自动选择，PLAYER_STREAM_DISABLED 为不播放音频
+*/
+PLAYER_API void player_settings_set_audio_stream(PlayerSettings* settings, int index);
+/**
+ * @brief 设置是否开启垂直同步
+ *
+ * 开启后每帧会显示在离其时间戳最近的垂直同步上，并可以统计错过的垂直同步。
+ * @param settings 播放器设置指针
+ * @param enable 是否开启，默认开启
+*/
+PLAYER_API void player_settings_set_vsync(PlayerSettings* settings, unsigned char enable);
+/**
+ * @brief 指定使用的视频流，未使用的流会在 demux 时直接丢弃
+ *
+ * 对播放列表中的后续文件同样生效。
+ * @param settings 播放器设置指针
+ * @param index 流序号，PLAYER_STREAM_AUTO 为自动选择，PLAYER_STREAM_DISABLED 为不播放视频
+*/
+PLAYER_API void player_settings_set_video_stream(PlayerSettings* settings, int index);
+/**
+ * @brief 设置探测缓存目录
+ *
+ * 以文件路径、大小和修改时间为键保存探测到的流信息和选择的流，再次打开同一文件时跳过探测。
+ * 只缓存本地文件，指定输入格式或启用低延迟模式时不使用。
+ * @param settings 播放器设置指针
+ * @param dir 已存在的目录，为NULL时不使用缓存（默认）
+ * @return 错误代码
+*/
+PLAYER_API int player_settings_set_probe_cache(PlayerSettings* settings, const char* dir);
+/**
+ * @brief 设置跳转索引目录
+ *
+ * 对没有索引或没有时长的本地文件（如 MPEG-TS、裸流、损坏的 MP4），播放到文件尾时记录关键帧的位置和时间，
+ * 再次打开时加载到 demuxer 的索引中，跳转时可以直接定位，没有时长时 player_get_duration 使用索引记录的时长。
+ * @param settings 播放器设置指针
+ * @param dir 已存在的目录，为NULL时不使用索引（默认）
+ * @return 错误代码
+*/
+PLAYER_API int player_settings_set_seek_index(PlayerSettings* settings, const char* dir);
+/**
+ * @brief 设置是否使用共享的音频输出
+ *
+ * 开启后多个会话共用一个音频设备，由混音器按各会话的音量混合输出（48kHz 立体声），
+ * 可以用 player_set_gain、player_set_mute 和 player_set_solo 控制每个会话。
+ * 设备使用第一个加入的会话的设备名称和周期设置。
+ * @param settings 播放器设置指针
+ * @param enable 是否开启，默认关闭
+*/
+PLAYER_API void player_settings_set_shared_audio_output(PlayerSettings* settings, unsigned char enable);
+/**
+ * @brief 设置线程优先级，在线程启动时应用，无法应用时降级处理（见 player_get_thread_info）
+ * @param settings 播放器设置指针
+ * @param thread PLAYER_THREAD_*
+ * @param priority PLAYER_THREAD_PRIORITY_*，默认 PLAYER_THREAD_PRIORITY_DEFAULT
+ * @return 错误代码
+*/
+PLAYER_API int player_settings_set_thread_priority(PlayerSettings* settings, int thread, int priority);
+/**
+ * @brief 设置线程的 CPU 亲和性
+ * @param settings 播放器设置指针
+ * @param thread PLAYER_THREAD_*
+ * @param mask 允许运行的 CPU 掩码，0 为不限制（默认）
+ * @return 错误代码
+*/
+PLAYER_API int player_settings_set_thread_affinity(PlayerSettings* settings, int thread, uint64_t mask);
+/**
+ * @brief 将线程绑定到 NUMA 节点，同时设置了亲和性时使用两者的交集
+ * @param settings 播放器设置指针
+ * @param thread PLAYER_THREAD_*
+ * @param node NUMA 节点序号，-1 为不绑定（默认）
+ * @return 错误代码
+*/
+PLAYER_API int player_settings_set_thread_numa_node(PlayerSettings* settings, int thread, int node);
 PLAYER_API void player_settings_free(PlayerSettings** settings);
 
+/**
+ * @brief 不打开任何设备，以最快速度将文件渲染到 WAV / Y4M 文件
+ *
+ * 使用与播放相同的解码、滤镜、音频转换和视频缩放流程，但由虚拟时钟驱动，结果是确定的。
+ * 会阻塞当前线程。
+ * @param url 要渲染的文件路径
+ * @param settings 播放器设置，如果为NULL会使用默认设置
+ * @param audio_path 输出音频的 WAV 文件路径，为NULL时不输出（仍会处理音频）
+ * @param video_path 输出视频的 Y4M 文件路径，为NULL时不输出（仍会处理视频）
+ * @param result 用于接收渲染结果的指针（可选）
+ * @return 错误代码
+ */
+PLAYER_API int player_render_to_file(const char* url, PlayerSettings* settings, const char* audio_path, const char* video_path, PlayerRenderResult* result);
+
+/**
+ * @brief 提取均匀分布的缩略图，只解码关键帧
+ *
+ * 会阻塞当前线程。
+ * @param url 文件路径
+ * @param count 缩略图数量
+ * @param width 缩略图宽度，<=0 时按高度保持比例
+ * @param height 缩略图高度，<=0 时按宽度保持比例
+ * @param callback 每提取一张缩略图调用一次
+ * @param userdata 传给回调的用户数据
+ * @return 错误代码
+ */
+PLAYER_API int player_extract_thumbnails(const char* url, int count, int width, int height, PlayerThumbnailCallback callback, void* userdata);
+/**
+ * @brief 多线程并行提取多个文件的缩略图
+ *
+ * 会阻塞当前线程，回调会在工作线程中调用。
+ * @param urls 文件路径数组
+ * @param url_count 文件数量
+ * @param threads 线程数，<=0 时使用 CPU 核心数
+ * @return 错误代码，多个文件失败时返回第一个错误
+ */
+PLAYER_API int player_extract_thumbnails_batch(const char** urls, int url_count, int count, int width, int height, PlayerThumbnailCallback callback, void* userdata, int threads);
+
 /**
  * @brief 直接播放一个文件，会创建一个新的窗口并自动播放，播放结束后自动销毁。
  * 
@@ -186,6 +855,15 @@ PLAYER_API void player_settings_free(PlayerSettings** settings);
  * @param hWnd 指向窗口句柄的指针（可选）
  */
 PLAYER_API void play(const char* filename, void** hWnd);
+/**
+ * @brief 扫描整个文件，为其建立跳转索引（见 player_settings_set_seek_index）
+ *
+ * 会阻塞当前线程，可以在后台线程中调用。已有索引或文件不需要索引时直接返回。
+ * @param url 文件路径
+ * @param dir 跳转索引目录
+ * @return 错误代码
+ */
+PLAYER_API int player_build_seek_index(const char* url, const char* dir);
 
 #ifdef __cplusplus
 }
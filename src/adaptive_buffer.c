@@ -0,0 +1,80 @@
+#include "adaptive_buffer.h"
+
+static int adaptive_buffer_enabled(PlayerSession* session) {
+    // 低延迟模式由目标延迟控制缓冲区大小
+    return session->settings->adaptive_buffer_max && !session->settings->low_latency;
+}
+
+void init_adaptive_buffer(PlayerSession* session) {
+    if (!session || !adaptive_buffer_enabled(session)) return;
+    // 从最小值开始，尽快开始播放
+    session->buffer_target = session->settings->adaptive_buffer_min;
+    session->buffer_last_grow = INT64_MIN;
+    session->buffer_last_change = av_gettime_relative();
+}
+
+uint32_t get_audio_buffer_size(PlayerSession* session) {
+    PlayerSettings* s = session->settings;
+    if (s->low_latency) return s->target_latency;
+    return adaptive_buffer_enabled(session) ? session->buffer_target : s->audio_buffer_size;
+}
+
+uint32_t get_video_buffer_size(PlayerSession* session) {
+    PlayerSettings* s = session->settings;
+    if (s->low_latency) return s->target_latency;
+    return adaptive_buffer_enabled(session) ? session->buffer_target : s->video_buffer_size;
+}
+
+static void set_buffer_target(PlayerSession* session, uint32_t size, int reason, int64_t now) {
+    AcquireSRWLockExclusive(&session->buffer_adjustment_lock);
+    PlayerBufferAdjustment* a = &session->buffer_adjustments[session->buffer_adjustment_count % PLAYER_BUFFER_ADJUSTMENT_LOG_SIZE];
+    a->time = now;
+    a->reason = reason;
+    a->old_size = session->buffer_target;
+    a->new_size = size;
+    a->audio_underruns = session->audio_underruns;
+    a->video_stalls = session->video_stalls;
+    session->buffer_adjustment_count++;
+    ReleaseSRWLockExclusive(&session->buffer_adjustment_lock);
+    av_log(NULL, AV_LOG_VERBOSE, "Buffer size changed from %u ms to %u ms (%s).\n", session->buffer_target, size, reason == PLAYER_BUFFER_SHRINK ? "shrink" : reason == PLAYER_BUFFER_GROW_UNDERRUN ? "audio underrun" : "video stall");
+    session->buffer_target = size;
+    if (session->has_audio) {
+        session->needed_audio_samples = (uint64_t)session->sdl_spec.freq * size / 1000;
+    }
+    session->buffer_last_change = now;
+}
+
+void update_adaptive_buffer(PlayerSession* session) {
+    if (!session || !adaptive_buffer_enabled(session)) return;
+    PlayerSettings* s = session->settings;
+    uint64_t underruns = session->audio_underruns, stalls = session->video_stalls;
+    int64_t now = av_gettime_relative();
+    if (underruns != session->buffer_seen_underruns || stalls != session->buffer_seen_stalls) {
+        int reason = underruns != session->buffer_seen_underruns ? PLAYER_BUFFER_GROW_UNDERRUN : PLAYER_BUFFER_GROW_STALL;
+        session->buffer_seen_underruns = underruns;
+        session->buffer_seen_stalls = stalls;
+        // 卡顿期间回调会连续记录多次，间隔内只增大一次
+        if (session->buffer_last_grow != INT64_MIN && now - session->buffer_last_grow < ADAPTIVE_BUFFER_GROW_INTERVAL) {
+            session->buffer_last_change = now;
+            return;
+        }
+        session->buffer_last_grow = now;
+        uint32_t size = (uint32_t)FFMIN(FFMAX((uint64_t)session->buffer_target * 2, 100), s->adaptive_buffer_max);
+        if (size != session->buffer_target) {
+            set_buffer_target(session, size, reason, now);
+        } else {
+            session->buffer_last_change = now;
+        }
+        return;
+    }
+    if (!session->is_playing) {
+        // 暂停时无法判断是否流畅
+        session->buffer_last_change = now;
+        return;
+    }
+    if (now - session->buffer_last_change >= ADAPTIVE_BUFFER_SHRINK_INTERVAL && session->buffer_target > s->adaptive_buffer_min) {
+        // 每次只缩小 1/4，避免缩小后立即卡顿
+        uint32_t size = FFMAX(session->buffer_target - session->buffer_target / 4, s->adaptive_buffer_min);
+        set_buffer_target(session, size, PLAYER_BUFFER_SHRINK, now);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef _PLAYER_ADAPTIVE_BUFFER_H
+#define _PLAYER_ADAPTIVE_BUFFER_H
+#if __cplusplus
+extern "C" {
+#endif
+#include "core.h"
+
+/// @brief 两次增大缓冲区之间的最小间隔（单位：微秒），同一次卡顿只增大一次
+#define ADAPTIVE_BUFFER_GROW_INTERVAL 1000000
+/// @brief 持续多长时间没有卡顿后缩小一次缓冲区（单位：微秒）
+#define ADAPTIVE_BUFFER_SHRINK_INTERVAL 30000000
+
+/// @brief 设置初始的缓冲区大小，需要在初始化音频输出前调用
+void init_adaptive_buffer(PlayerSession* session);
+/// @brief 当前使用的音频缓冲区大小（单位 ms）
+uint32_t get_audio_buffer_size(PlayerSession* session);
+/// @brief 当前使用的视频数据包缓冲区大小（单位 ms）
+uint32_t get_video_buffer_size(PlayerSession* session);
+/// @brief 根据卡顿记录调整缓冲区大小（仅解码线程调用）
+void update_adaptive_buffer(PlayerSession* session);
+#if __cplusplus
+}
+#endif
+#endif
@@ -1,9 +1,19 @@
 #include "audio_output.h"
+#include "mixer.h"
+#include "trace.h"
+#include "adaptive_buffer.h"
+#include "loop.h"
 
 int init_audio_output(PlayerSession* session) {
     if (!session) return PLAYER_ERR_NULLPTR;
     if (!session->has_audio) return PLAYER_ERR_OK;
     if (!session->audio_decoder) return PLAYER_ERR_NULLPTR;
+    if (session->settings->shared_audio_output) {
+        // 使用共享的混音器，转换到混音器的格式
+        int re = mixer_add_session(session);
+        if (re) return re;
+        return init_audio_conversion(session);
+    }
     SDL_AudioSpec sdl_spec;
     sdl_spec.freq = session->audio_decoder->sample_rate;
     sdl_spec.format = convert_to_sdl_format(session->audio_decoder->sample_fmt);
@@ -13,39 +23,93 @@ int init_audio_output(PlayerSession* session) {
         return PLAYER_ERR_UNKNOWN_AUDIO_SAMPLE_FMT;
     }
     sdl_spec.channels = session->audio_decoder->ch_layout.nb_channels;
-    sdl_spec.samples = session->audio_decoder->sample_rate / 100;
+    sdl_spec.samples = session->settings->audio_period ? session->settings->audio_period : session->audio_decoder->sample_rate / 100;
     sdl_spec.callback = SDL_audio_callback;
     sdl_spec.userdata = session;
     memcpy(&session->sdl_spec, &sdl_spec, sizeof(SDL_AudioSpec));
-    session->device_id = SDL_OpenAudioDevice(NULL, 0, &sdl_spec, &session->sdl_spec, 0);
+    session->device_id = SDL_OpenAudioDevice(session->settings->audio_device, 0, &sdl_spec, &session->sdl_spec, session->settings->audio_allowed_changes);
     if (!session->device_id) {
         av_log(NULL, AV_LOG_FATAL, "Failed to open audio device: %s\n", SDL_GetError());
         return PLAYER_ERR_SDL;
     }
-    enum AVSampleFormat target_format = convert_to_sdl_supported_format(session->audio_decoder->sample_fmt);
+    if (convert_from_sdl_format(session->sdl_spec.format) == AV_SAMPLE_FMT_NONE) {
+        // 设备选择了无法直接输出的格式（如 S8、U16 或非本机字节序），改为由 SDL 转换
+        av_log(NULL, AV_LOG_VERBOSE, "Audio device format 0x%x is not supported, reopening without format change.\n", session->sdl_spec.format);
+        SDL_CloseAudioDevice(session->device_id);
+        memcpy(&session->sdl_spec, &sdl_spec, sizeof(SDL_AudioSpec));
+        session->device_id = SDL_OpenAudioDevice(session->settings->audio_device, 0, &sdl_spec, &session->sdl_spec, session->settings->audio_allowed_changes & ~SDL_AUDIO_ALLOW_FORMAT_CHANGE);
+        if (!session->device_id) {
+            av_log(NULL, AV_LOG_FATAL, "Failed to open audio device: %s\n", SDL_GetError());
+            return PLAYER_ERR_SDL;
+        }
+    }
+    // 设备实际使用的格式可能与请求的不同，之后的转换都以实际格式为准
+    av_log(NULL, AV_LOG_VERBOSE, "Audio device opened: %dHz, %d channels, format 0x%x, %d samples per period.\n", session->sdl_spec.freq, session->sdl_spec.channels, session->sdl_spec.format, session->sdl_spec.samples);
+    return init_audio_conversion(session);
+}
+
+int init_offline_audio_output(PlayerSession* session) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    if (!session->has_audio) return PLAYER_ERR_OK;
+    if (!session->audio_decoder) return PLAYER_ERR_NULLPTR;
+    // 不打开设备，直接使用解码器的格式
+    memset(&session->sdl_spec, 0, sizeof(SDL_AudioSpec));
+    session->sdl_spec.freq = session->audio_decoder->sample_rate;
+    session->sdl_spec.format = convert_to_sdl_format(session->audio_decoder->sample_fmt);
+    if (!session->sdl_spec.format) {
+        const char* tmp = av_get_sample_fmt_name(session->audio_decoder->sample_fmt);
+        av_log(NULL, AV_LOG_FATAL, "Unknown sample format: %s (%i)\n", tmp ? tmp : "", session->audio_decoder->sample_fmt);
+        return PLAYER_ERR_UNKNOWN_AUDIO_SAMPLE_FMT;
+    }
+    session->sdl_spec.channels = session->audio_decoder->ch_layout.nb_channels;
+    session->sdl_spec.samples = session->settings->audio_period ? session->settings->audio_period : session->audio_decoder->sample_rate / 100;
+    int re = init_audio_conversion(session);
+    // 没有设备缓冲区
+    session->audio_device_latency = 0;
+    return re;
+}
+
+int init_audio_conversion(PlayerSession* session) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    enum AVSampleFormat target_format = convert_from_sdl_format(session->sdl_spec.format);
+    if (target_format == AV_SAMPLE_FMT_NONE) {
+        av_log(NULL, AV_LOG_FATAL, "Unsupported audio device format: 0x%x\n", session->sdl_spec.format);
+        return PLAYER_ERR_UNKNOWN_AUDIO_SAMPLE_FMT;
+    }
     int re = 0;
-    if (re = get_sdl_channel_layout(session->audio_decoder->ch_layout.nb_channels, &session->output_channel_layout)) {
+    if (re = get_sdl_channel_layout(session->sdl_spec.channels, &session->output_channel_layout)) {
         return re;
     }
-    if (re = swr_alloc_set_opts2(&session->swrac, &session->output_channel_layout, target_format, session->sdl_spec.freq, &session->audio_decoder->ch_layout, session->audio_decoder->sample_fmt, session->audio_decoder->sample_rate, 0, NULL)) {
+    // SDL 自身缓冲一个周期，设备至少还有一个周期在播放；系统混音器的缓冲无法查询，因此这只是下限
+    session->audio_device_latency = av_rescale(2 * (int64_t)session->sdl_spec.samples, AV_TIME_BASE, session->sdl_spec.freq);
+    session->target_format = target_format;
+    session->target_format_pbytes = av_get_bytes_per_sample(target_format);
+    if ((re = init_audio_resampler(session, session->audio_decoder, &session->swrac))) {
+        return re;
+    }
+    if (!(session->buffer = av_audio_fifo_alloc(target_format, session->sdl_spec.channels, 1))) {
+        av_log(NULL, AV_LOG_FATAL, "Failed to allocate audio buffer.\n");
+        return PLAYER_ERR_OOM;
+    }
+    session->needed_audio_samples = (uint64_t)session->sdl_spec.freq * get_audio_buffer_size(session) / 1000;
+    return PLAYER_ERR_OK;
+}
+
+int init_audio_resampler(PlayerSession* session, AVCodecContext* decoder, struct SwrContext** swrac) {
+    if (!session || !decoder || !swrac) return PLAYER_ERR_NULLPTR;
+    int re = 0;
+    if (re = swr_alloc_set_opts2(swrac, &session->output_channel_layout, session->target_format, session->sdl_spec.freq, &decoder->ch_layout, decoder->sample_fmt, decoder->sample_rate, 0, NULL)) {
         av_log(NULL, AV_LOG_FATAL, "Failed to allocate resample context: %s (%i)\n", av_err2str(re), re);
         return re;
     }
-    if (!session->swrac) {
+    if (!*swrac) {
         av_log(NULL, AV_LOG_FATAL, "Failed to allocate resample context.\n");
         return PLAYER_ERR_OOM;
     }
-    if ((re = swr_init(session->swrac)) < 0) {
+    if ((re = swr_init(*swrac)) < 0) {
         av_log(NULL, AV_LOG_FATAL, "Failed to initialize resample context: %s (%i)\n", av_err2str(re), re);
         return re;
     }
-    if (!(session->buffer = av_audio_fifo_alloc(target_format, session->audio_decoder->ch_layout.nb_channels, 1))) {
-        av_log(NULL, AV_LOG_FATAL, "Failed to allocate audio buffer.\n");
-        return PLAYER_ERR_OOM;
-    }
-    session->target_format = target_format;
-    session->target_format_pbytes = av_get_bytes_per_sample(target_format);
-    session->needed_audio_samples = session->sdl_spec.freq * session->settings->audio_buffer_size / 1000;
     return PLAYER_ERR_OK;
 }
 
@@ -68,6 +132,21 @@ enum AVSampleFormat convert_to_sdl_supported_format(enum AVSampleFormat fmt) {
     }
 }
 
+enum AVSampleFormat convert_from_sdl_format(SDL_AudioFormat fmt) {
+    switch (fmt) {
+        case AUDIO_U8:
+            return AV_SAMPLE_FMT_U8;
+        case AUDIO_S16SYS:
+            return AV_SAMPLE_FMT_S16;
+        case AUDIO_S32SYS:
+            return AV_SAMPLE_FMT_S32;
+        case AUDIO_F32SYS:
+            return AV_SAMPLE_FMT_FLT;
+        default:
+            return AV_SAMPLE_FMT_NONE;
+    }
+}
+
 SDL_AudioFormat convert_to_sdl_format(enum AVSampleFormat fmt) {
     fmt = convert_to_sdl_supported_format(fmt);
     switch (fmt) {
@@ -84,22 +163,23 @@ SDL_AudioFormat convert_to_sdl_format(enum AVSampleFormat fmt) {
     }
 }
 
-void SDL_audio_callback(void* userdata, uint8_t* stream, int len) {
-    PlayerSession* session = (PlayerSession*)userdata;
-    if (!session) return;
-    DWORD re = WaitForSingleObject(session->mutex, 10);
+int read_audio_buffer(PlayerSession* session, uint8_t* stream, int len, DWORD timeout) {
+    DWORD re = WaitForSingleObject(session->mutex, timeout);
     if (re != WAIT_OBJECT_0) {
         // 无法获取Mutex所有权，填充空白数据
         memset(stream, 0, len);
-        return;
+        return -1;
+    }
+    int samples_need = len / session->target_format_pbytes / session->sdl_spec.channels;
+    int writed = 0;
+    if (session->is_playing && !session->audio_is_eof && av_audio_fifo_size(session->buffer) < samples_need) {
+        session->audio_underruns++;
     }
-    int samples_need = len / session->target_format_pbytes / session->audio_decoder->ch_layout.nb_channels;
-    int buffer_size = session->sdl_spec.freq / 5;
     if (av_audio_fifo_size(session->buffer) == 0) {
         // 缓冲区为空，填充空白数据
         memset(stream, 0, len);
     } else {
-        int writed = av_audio_fifo_read(session->buffer, (void**)&stream, samples_need);
+        writed = av_audio_fifo_read(session->buffer, (void**)&stream, samples_need);
         if (writed > 0) {
             AVRational base = {1, session->sdl_spec.freq};
             session->pts += av_rescale_q_rnd(writed, base, AV_TIME_BASE_Q, AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
@@ -107,13 +187,46 @@ void SDL_audio_callback(void* userdata, uint8_t* stream, int len) {
         }
         if (writed < 0) {
             memset(stream, 0, len);
+            writed = 0;
         } else if (writed < samples_need) {
-            size_t len = ((size_t)samples_need - writed) * session->target_format_pbytes, alen = (size_t)writed * session->target_format_pbytes;
+            size_t len = ((size_t)samples_need - writed) * session->target_format_pbytes * session->sdl_spec.channels, alen = (size_t)writed * session->target_format_pbytes * session->sdl_spec.channels;
             // 不足的区域用空白数据填充
             memset(stream + alen, 0, len);
         }
     }
+    // 只在缓冲区低于目标大小时唤醒解码线程，解码结束后缓冲区播放完时唤醒以停止播放
+    int remain = av_audio_fifo_size(session->buffer);
+    char need_more = session->audio_is_eof ? remain == 0 : remain < session->needed_audio_samples;
     ReleaseMutex(session->mutex);
+    if (need_more) wake_decode_loop(session);
+    return writed;
+}
+
+void SDL_audio_callback(void* userdata, uint8_t* stream, int len) {
+    PlayerSession* session = (PlayerSession*)userdata;
+    if (!session) return;
+    int64_t trace_start = TRACE_BEGIN();
+    read_audio_buffer(session, stream, len, 10);
+    TRACE_END("audio callback", trace_start, session->pts);
+}
+
+void set_audio_output_paused(PlayerSession* session, int paused) {
+    if (!session || !session->has_audio) return;
+    if (session->use_mixer) {
+        session->mixer_playing = paused ? 0 : 1;
+    } else if (session->device_id) {
+        SDL_PauseAudioDevice(session->device_id, paused);
+    }
+}
+
+void close_audio_output(PlayerSession* session) {
+    if (!session || !session->has_audio) return;
+    if (session->use_mixer) {
+        mixer_remove_session(session);
+    } else if (session->device_id) {
+        SDL_CloseAudioDevice(session->device_id);
+        session->device_id = 0;
+    }
 }
 
 int get_sdl_channel_layout(int channels, AVChannelLayout* channel_layout) {
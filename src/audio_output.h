@@ -5,9 +5,25 @@ extern "C" {
 #endif
 #include "core.h"
 int init_audio_output(PlayerSession* session);
+/// @brief 不打开音频设备，按解码器的格式初始化转换（用于离线渲染）
+int init_offline_audio_output(PlayerSession* session);
+/// @brief 根据 sdl_spec 初始化重采样和缓冲区
+int init_audio_conversion(PlayerSession* session);
+int init_audio_resampler(PlayerSession* session, AVCodecContext* decoder, struct SwrContext** swrac);
 enum AVSampleFormat convert_to_sdl_supported_format(enum AVSampleFormat fmt);
 SDL_AudioFormat convert_to_sdl_format(enum AVSampleFormat fmt);
+enum AVSampleFormat convert_from_sdl_format(SDL_AudioFormat fmt);
+/**
+ * @brief 从音频缓冲区读取数据并更新音频时钟，不足的部分填充空白数据
+ * @param timeout 等待会话 mutex 的最长时间（单位 ms），超时时全部填充空白数据
+ * @return 读取的样本数，超时时返回 -1
+*/
+int read_audio_buffer(PlayerSession* session, uint8_t* stream, int len, DWORD timeout);
 void SDL_audio_callback(void* userdata, uint8_t* stream, int len);
+/// @brief 暂停或继续音频输出（独占的设备或混音器）
+void set_audio_output_paused(PlayerSession* session, int paused);
+/// @brief 关闭音频设备或从混音器中移除
+void close_audio_output(PlayerSession* session);
 int get_sdl_channel_layout(int channels, AVChannelLayout* channel_layout);
 #if __cplusplus
 }
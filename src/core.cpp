@@ -7,6 +7,15 @@
 #include "audio_output.h"
 #include "video_output.h"
 #include "loop.h"
+#include "playlist.h"
+#include "filter.h"
+#include "render.h"
+#include "thumbnail.h"
+#include "probe_cache.h"
+#include "seek_index.h"
+#include "mixer.h"
+#include "trace.h"
+#include "adaptive_buffer.h"
 
 static FILE* log_file = nullptr;
 static int log_max_level = AV_LOG_INFO;
@@ -67,6 +76,22 @@ const char* player_get_err_msg2(int err) {
         return "Failed to create thread";
     case PLAYER_ERR_NO_DURATION:
         return "No duration";
+    case PLAYER_ERR_NEXT_ITEM_PENDING:
+        return "Next item is already pending";
+    case PLAYER_ERR_INCOMPATIBLE_NEXT_ITEM:
+        return "Next item does not have the same streams";
+    case PLAYER_ERR_OPEN_FILE:
+        return "Failed to open file";
+    case PLAYER_ERR_INVALID_STREAM:
+        return "Invalid stream";
+    case PLAYER_ERR_TOO_MANY_SESSIONS:
+        return "Too many sessions in shared audio output";
+    case PLAYER_ERR_CANCELLED:
+        return "Cancelled";
+    case PLAYER_ERR_FAILED_CREATE_EVENT:
+        return "Failed to create event";
+    case PLAYER_ERR_INVALID_ARGUMENT:
+        return "Invalid argument";
     default:
         return "Unknown error";
     }
@@ -76,10 +101,46 @@ int player_create(const char* url, PlayerSession** session) {
     return player_create2(url, session, nullptr);
 }
 
-int player_create2(const char* url, PlayerSession** session, PlayerSettings* settings) {
-    if (!url || !session) return PLAYER_ERR_NULLPTR;
+/**
+ * @brief 记录异步创建中的会话，取消时可以中断会话中的读取
+ * @param ses 为NULL时表示会话已创建完成或已释放
+*/
+static void set_request_session(PlayerCreateRequest* request, PlayerSession* ses) {
+    if (!request) return;
+    AcquireSRWLockExclusive(&request->lock);
+    request->session = ses;
+    if (ses && request->cancelled) ses->interrupted = 1;
+    ReleaseSRWLockExclusive(&request->lock);
+}
+
+static const char* init_step_names[PLAYER_INIT_STEP_COUNT] = {
+    "open input", "find streams", "SDL init", "audio decoder", "video decoder", "audio output", "video output"
+};
+
+/**
+ * @brief 记录一个初始化步骤的耗时
+ * @param stats 为NULL时不记录
+ * @param base 开始创建的时间
+ * @param start 步骤开始的时间
+*/
+static void record_init_step(PlayerInitStats* stats, int step, int64_t base, int64_t start) {
+    if (!stats) return;
+    int64_t now = av_gettime_relative();
+    stats->steps[step].start = start - base;
+    stats->steps[step].duration = now - start;
+    TRACE_END(init_step_names[step], trace_enabled ? start : 0, AV_NOPTS_VALUE);
+}
+
+/**
+ * @brief 分配会话，打开文件并选择流
+ * @param request 异步创建请求，同步创建时为NULL
+ * @param stats 用于记录各步骤耗时，可为NULL
+ * @param base 开始创建的时间
+*/
+static int session_probe(const char* url, PlayerSession** session, PlayerSettings* settings, PlayerCreateRequest* request, PlayerInitStats* stats, int64_t base) {
     PlayerSession* ses = (PlayerSession*)malloc(sizeof(PlayerSession));
     int re = PLAYER_ERR_OK;
+    int64_t start;
     if (!ses) {
         av_log(nullptr, AV_LOG_ERROR, "Failed to allocate memory for PlayerSession.\n");
         return PLAYER_ERR_OOM;
@@ -100,10 +161,27 @@ int player_create2(const char* url, PlayerSession** session, PlayerSettings* set
     ses->video_first_pts = INT64_MIN;
     ses->next_video_timestamp = INT64_MIN;
     ses->last_pts_timestamp = INT64_MIN;
+    ses->clock_start_timestamp = INT64_MIN;
+    ses->requested_audio_stream = -1;
+    ses->last_vsync_timestamp = INT64_MIN;
+    ses->pacing.last_present_time = INT64_MIN;
+    InitializeSRWLock(&ses->pacing_lock);
+    InitializeSRWLock(&ses->buffer_adjustment_lock);
+    ses->mixer_gain = 1.0f;
+    ses->speed = av_d2q(ses->settings->speed, 1000);
+    init_adaptive_buffer(ses);
+    set_request_session(request, ses);
+    start = av_gettime_relative();
     if ((re = open_input(ses, url))) {
         goto end;
     }
+    record_init_step(stats, PLAYER_INIT_OPEN_INPUT, base, start);
+    if (ses->interrupted) {
+        re = PLAYER_ERR_CANCELLED;
+        goto end;
+    }
     av_dump_format(ses->fmt, 0, url, 0);
+    start = av_gettime_relative();
     re = find_audio_stream(ses);
     if (!re) {
         ses->has_audio = 1;
@@ -113,6 +191,12 @@ int player_create2(const char* url, PlayerSession** session, PlayerSettings* set
         goto end;
     }
     re = find_video_stream(ses);
+    if (!re && (ses->video_input_stream->disposition & AV_DISPOSITION_ATTACHED_PIC)) {
+        // 指定了附加图片，作为封面显示
+        ses->cover_stream = ses->video_input_stream;
+        ses->video_input_stream = nullptr;
+        re = PLAYER_ERR_NO_STREAM_OR_DECODER;
+    }
     if (!re) {
         ses->has_video = 1;
     } else if (re == PLAYER_ERR_NO_STREAM_OR_DECODER) {
@@ -120,80 +204,363 @@ int player_create2(const char* url, PlayerSession** session, PlayerSettings* set
     } else {
         goto end;
     }
+    // 只有音频时显示封面：只解码一次，不使用视频缓冲区、解码线程和定时刷新
+    if (!ses->has_video && ses->has_audio && (ses->cover_stream || !find_cover_stream(ses, &ses->cover_stream))) {
+        if (!decode_cover(ses)) ses->has_cover = 1;
+    }
     if (!ses->has_audio && !ses->has_video) {
         av_log(nullptr, AV_LOG_ERROR, "No audio and video stream found.\n");
         re = PLAYER_ERR_NO_STREAM_OR_DECODER;
         goto end;
     }
-    if ((re = open_audio_decoder(ses))) {
+    discard_unused_streams(ses);
+    probe_cache_store(ses, url);
+    record_init_step(stats, PLAYER_INIT_FIND_STREAMS, base, start);
+    ses->mutex = CreateMutexW(nullptr, FALSE, nullptr);
+    if (!ses->mutex) {
+        re = PLAYER_ERR_FAILED_CREATE_MUTEX;
+        goto end;
+    }
+    ses->video_mutex = CreateMutexW(nullptr, FALSE, nullptr);
+    if (!ses->video_mutex) {
+        re = PLAYER_ERR_FAILED_CREATE_MUTEX;
+        goto end;
+    }
+    // 线程空闲时等待这两个事件，不定时轮询
+    ses->decode_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    ses->event_wakeup = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    ses->decode_parked_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!ses->decode_event || !ses->event_wakeup || !ses->decode_parked_event) {
+        re = PLAYER_ERR_FAILED_CREATE_EVENT;
+        goto end;
+    }
+    *session = ses;
+    return re;
+end:
+    if (ses->interrupted) re = PLAYER_ERR_CANCELLED;
+    set_request_session(request, nullptr);
+    player_free(&ses);
+    *session = nullptr;
+    return re;
+}
+
+/// @brief 打开音频解码器和滤镜，只访问音频相关的字段，可以与 open_video 同时进行
+static int open_audio(PlayerSession* ses, PlayerInitStats* stats, int64_t base) {
+    int64_t start = av_gettime_relative();
+    int re = open_audio_decoder(ses);
+    if (!re) re = init_audio_filter(ses);
+    if (!re && ses->has_audio) record_init_step(stats, PLAYER_INIT_AUDIO_DECODER, base, start);
+    return re;
+}
+
+/// @brief 打开视频解码器和滤镜，只访问视频相关的字段
+static int open_video(PlayerSession* ses, PlayerInitStats* stats, int64_t base) {
+    int64_t start = av_gettime_relative();
+    int re = open_video_decoder(ses);
+    if (!re) re = init_video_filter(ses);
+    if (!re && ses->has_video) record_init_step(stats, PLAYER_INIT_VIDEO_DECODER, base, start);
+    return re;
+}
+
+/**
+ * @brief 分配会话，打开文件和解码器，不涉及任何输出设备
+*/
+static int session_open(const char* url, PlayerSession** session, PlayerSettings* settings) {
+    PlayerSession* ses = nullptr;
+    int re = session_probe(url, &ses, settings, nullptr, nullptr, 0);
+    if (re) {
+        *session = nullptr;
+        return re;
+    }
+    if ((re = open_audio(ses, nullptr, 0)) || (re = open_video(ses, nullptr, 0))) {
+        player_free(&ses);
+        *session = nullptr;
+        return re;
+    }
+    *session = ses;
+    return re;
+}
+
+/// @brief 与探测、打开解码器同时进行的 SDL 初始化
+typedef struct SdlInitTask {
+    /// @brief 要初始化的子系统
+    uint32_t flags;
+    /// @brief SDL_InitSubSystem 的返回值，未执行或子系统已交给会话时为 -1
+    int re;
+    /// @brief 初始化的开始和结束时间
+    int64_t start;
+    int64_t end;
+} SdlInitTask;
+
+static DWORD WINAPI sdl_init_thread(LPVOID param) {
+    SdlInitTask* t = (SdlInitTask*)param;
+    t->start = av_gettime_relative();
+    t->re = SDL_InitSubSystem(t->flags);
+    t->end = av_gettime_relative();
+    TRACE_END(init_step_names[PLAYER_INIT_SDL], trace_enabled ? t->start : 0, AV_NOPTS_VALUE);
+    return 0;
+}
+
+/// @brief 把 SDL 初始化的耗时合并到 PLAYER_INIT_SDL（两个任务的时间可能重叠）
+static void record_sdl_step(PlayerInitStats* stats, int64_t base, int64_t start, int64_t end) {
+    PlayerInitStep* step = &stats->steps[PLAYER_INIT_SDL];
+    int64_t s = start - base, e = end - base;
+    if (step->duration) {
+        s = FFMIN(s, step->start);
+        e = FFMAX(e, step->start + step->duration);
+    }
+    step->start = s;
+    step->duration = e - s;
+}
+
+static void join_thread(HANDLE* thread) {
+    if (!*thread) return;
+    WaitForSingleObject(*thread, INFINITE);
+    CloseHandle(*thread);
+    *thread = NULL;
+}
+
+/// @brief 与视频解码器同时进行的音频初始化
+typedef struct AudioInitTask {
+    PlayerSession* ses;
+    /// @brief 打开音频设备前只需要等待音频子系统初始化完成
+    HANDLE sdl_thread;
+    SdlInitTask* sdl;
+    PlayerInitStats* stats;
+    int64_t base;
+    int re;
+    /// @brief 是否已打开音频输出
+    unsigned char output_opened;
+} AudioInitTask;
+
+static DWORD WINAPI audio_init_thread(LPVOID param) {
+    AudioInitTask* t = (AudioInitTask*)param;
+    PlayerSession* ses = t->ses;
+    if ((t->re = open_audio(ses, t->stats, t->base)) || !ses->has_audio) return 0;
+    if (t->sdl_thread) WaitForSingleObject(t->sdl_thread, INFINITE);
+    // SDL 初始化失败时由创建线程按实际需要的子系统重试
+    if (t->sdl->re || ses->interrupted) return 0;
+    int64_t start = av_gettime_relative();
+    if (!(t->re = init_audio_output(ses))) {
+        record_init_step(t->stats, PLAYER_INIT_AUDIO_OUTPUT, t->base, start);
+    }
+    t->output_opened = 1;
+    return 0;
+}
+
+/**
+ * @brief 打开文件并初始化输出，启动解码和事件处理线程
+ *
+ * 音频子系统的初始化与打开文件和探测同时进行，视频和事件子系统在探测到视频或封面后才初始化；
+ * 之后音频解码器、音频设备与视频解码器、视频缓冲区同时进行，音频设备只等待音频子系统。
+ * @param request 异步创建请求，同步创建时为NULL
+*/
+static int session_create(const char* url, PlayerSession** session, PlayerSettings* settings, PlayerCreateRequest* request) {
+    PlayerSession* ses = nullptr;
+    int re = PLAYER_ERR_OK;
+    int64_t base = av_gettime_relative(), start;
+    PlayerInitStats stats;
+    SdlInitTask sdl_audio, sdl_video;
+    AudioInitTask audio;
+    HANDLE sdl_audio_thread = NULL, sdl_video_thread = NULL, audio_thread = NULL;
+    uint32_t needed = 0, owned = 0, missing = 0;
+    memset(&stats, 0, sizeof(PlayerInitStats));
+    memset(&sdl_audio, 0, sizeof(SdlInitTask));
+    memset(&sdl_video, 0, sizeof(SdlInitTask));
+    memset(&audio, 0, sizeof(AudioInitTask));
+    sdl_audio.re = -1;
+    sdl_video.re = -1;
+    // 还不知道有哪些流，先按设置初始化可能需要的音频子系统，纯视频文件之后再释放
+    sdl_audio.flags = SDL_INIT_AUDIO;
+    if (!settings || settings->audio_stream_index != PLAYER_STREAM_DISABLED) {
+        sdl_audio_thread = CreateThread(nullptr, 0, sdl_init_thread, &sdl_audio, 0, NULL);
+    }
+    if ((re = session_probe(url, &ses, settings, request, &stats, base))) {
         goto end;
     }
-    if ((re = open_video_decoder(ses))) {
+    if (ses->has_audio) needed |= SDL_INIT_AUDIO;
+    if (ses->has_video) needed |= SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_EVENTS;
+    else if (ses->has_cover) needed |= SDL_INIT_VIDEO | SDL_INIT_EVENTS;
+    // 纯音频文件不初始化视频和事件子系统
+    sdl_video.flags = needed & ~SDL_INIT_AUDIO;
+    if (sdl_video.flags) sdl_video_thread = CreateThread(nullptr, 0, sdl_init_thread, &sdl_video, 0, NULL);
+    audio.ses = ses;
+    audio.sdl_thread = sdl_audio_thread;
+    audio.sdl = &sdl_audio;
+    audio.stats = &stats;
+    audio.base = base;
+    if (!(audio_thread = CreateThread(nullptr, 0, audio_init_thread, &audio, 0, NULL))) {
+        audio_init_thread(&audio);
+    }
+    if ((re = open_video(ses, &stats, base))) {
         goto end;
     }
-    if (SDL_InitSubSystem(SDL_INIT_AUDIO | SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_EVENTS)) {
-        av_log(nullptr, AV_LOG_ERROR, "Failed to initialize SDL: %s\n", SDL_GetError());
-        re = PLAYER_ERR_SDL;
+    start = av_gettime_relative();
+    if ((re = init_video_buffer(ses))) {
         goto end;
     }
-    ses->sdl_initialized = 1;
-    if ((re = init_audio_output(ses))) {
+    if (ses->has_video) record_init_step(&stats, PLAYER_INIT_VIDEO_OUTPUT, base, start);
+    join_thread(&audio_thread);
+    if ((re = audio.re)) {
         goto end;
     }
-    if (ses->has_video) {
-        AVRational tb = { 1, 1000 };
-        AVRational rps = { ses->video_decoder->framerate.den, ses->video_decoder->framerate.num };
-        ses->needed_video_frames = av_rescale_q(ses->settings->video_buffer_size, tb, rps);
-        ses->video_buffer = av_fifo_alloc2(ses->needed_video_frames, sizeof(AVFrame*), 0);
-        if (!ses->video_buffer) {
-            av_log(nullptr, AV_LOG_ERROR, "Failed to allocate video buffer.\n");
-            re = PLAYER_ERR_OOM;
-            goto end;
-        }
+    join_thread(&sdl_audio_thread);
+    join_thread(&sdl_video_thread);
+    // 把初始化成功的子系统交给会话，释放不需要的
+    if (!sdl_audio.re) {
+        record_sdl_step(&stats, base, sdl_audio.start, sdl_audio.end);
+        if (needed & SDL_INIT_AUDIO) owned |= SDL_INIT_AUDIO;
+        else SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        sdl_audio.re = -1;
     }
-    if (ses->settings->hWnd) {
-        if ((re = init_video_output(ses))) {
+    if (!sdl_video.re) {
+        record_sdl_step(&stats, base, sdl_video.start, sdl_video.end);
+        owned |= sdl_video.flags;
+        sdl_video.re = -1;
+    }
+    if (owned) {
+        ses->sdl_init_flags = owned;
+        ses->sdl_initialized = 1;
+    }
+    missing = needed & ~owned;
+    if (missing) {
+        start = av_gettime_relative();
+        if (SDL_InitSubSystem(missing)) {
+            av_log(nullptr, AV_LOG_ERROR, "Failed to initialize SDL: %s\n", SDL_GetError());
+            re = PLAYER_ERR_SDL;
             goto end;
         }
+        ses->sdl_init_flags |= missing;
+        ses->sdl_initialized = 1;
+        record_sdl_step(&stats, base, start, av_gettime_relative());
     }
-    ses->mutex = CreateMutexW(nullptr, FALSE, nullptr);
-    if (!ses->mutex) {
-        re = PLAYER_ERR_FAILED_CREATE_MUTEX;
+    if (ses->interrupted) {
+        re = PLAYER_ERR_CANCELLED;
         goto end;
     }
-    ses->video_mutex = CreateMutexW(nullptr, FALSE, nullptr);
-    if (!ses->video_mutex) {
-        re = PLAYER_ERR_FAILED_CREATE_MUTEX;
-        goto end;
+    if (!audio.output_opened) {
+        start = av_gettime_relative();
+        if ((re = init_audio_output(ses))) {
+            goto end;
+        }
+        if (ses->has_audio) record_init_step(&stats, PLAYER_INIT_AUDIO_OUTPUT, base, start);
+    }
+    if (ses->settings->hWnd) {
+        start = av_gettime_relative();
+        if ((re = init_video_output(ses)) || (re = init_cover_output(ses))) {
+            goto end;
+        }
+        stats.steps[PLAYER_INIT_VIDEO_OUTPUT].duration += av_gettime_relative() - start;
     }
     ses->decode_thread = CreateThread(nullptr, 0, decode_loop, ses, 0, NULL);
     if (!ses->decode_thread) {
         re = PLAYER_ERR_FAILED_CREATE_THREAD;
         goto end;
     }
-    ses->event_thread = CreateThread(nullptr, 0, ses->is_external_window ? external_window_event_loop : event_loop, ses, 0, NULL);
-    if (!ses->event_thread) {
-        re = PLAYER_ERR_FAILED_CREATE_THREAD;
-        goto end;
+    if (ses->has_video || ses->has_cover) {
+        ses->event_thread = CreateThread(nullptr, 0, ses->has_cover ? cover_event_loop : ses->is_external_window ? external_window_event_loop : event_loop, ses, 0, NULL);
+        if (!ses->event_thread) {
+            re = PLAYER_ERR_FAILED_CREATE_THREAD;
+            goto end;
+        }
     }
+    stats.total = av_gettime_relative() - base;
+    memcpy(&ses->init_stats, &stats, sizeof(PlayerInitStats));
+    av_log(nullptr, AV_LOG_VERBOSE, "Session created in %lld us.\n", stats.total);
     *session = ses;
     return re;
 end:
-    player_free(&ses);
+    // 先等待其他线程结束，它们仍在使用会话
+    join_thread(&audio_thread);
+    join_thread(&sdl_audio_thread);
+    join_thread(&sdl_video_thread);
+    if (ses) {
+        if (ses->interrupted) re = PLAYER_ERR_CANCELLED;
+        set_request_session(request, nullptr);
+        player_free(&ses);
+    }
+    // 会话已关闭音频设备，再释放尚未交给会话的子系统
+    if (!sdl_audio.re) SDL_QuitSubSystem(sdl_audio.flags);
+    if (!sdl_video.re) SDL_QuitSubSystem(sdl_video.flags);
     *session = nullptr;
     return re;
 }
 
+int player_create2(const char* url, PlayerSession** session, PlayerSettings* settings) {
+    if (!url || !session) return PLAYER_ERR_NULLPTR;
+    return session_create(url, session, settings, nullptr);
+}
+
+static DWORD WINAPI create_thread(LPVOID param) {
+    PlayerCreateRequest* r = (PlayerCreateRequest*)param;
+    PlayerSession* ses = nullptr;
+    int re = session_create(r->url, &ses, r->settings, r);
+    AcquireSRWLockExclusive(&r->lock);
+    r->session = nullptr;
+    unsigned char cancelled = r->cancelled;
+    ReleaseSRWLockExclusive(&r->lock);
+    if (cancelled) {
+        // 创建完成后才取消，同样不返回会话
+        player_free(&ses);
+        re = PLAYER_ERR_CANCELLED;
+    }
+    r->callback(r->userdata, ses, re);
+    return 0;
+}
+
+int player_create_async(const char* url, PlayerSettings* settings, PlayerCreateCallback callback, void* userdata, PlayerCreateRequest** request) {
+    if (!url || !callback || !request) return PLAYER_ERR_NULLPTR;
+    PlayerCreateRequest* r = (PlayerCreateRequest*)av_mallocz(sizeof(PlayerCreateRequest));
+    if (!r) return PLAYER_ERR_OOM;
+    if (!(r->url = av_strdup(url))) {
+        av_free(r);
+        return PLAYER_ERR_OOM;
+    }
+    r->settings = settings;
+    r->callback = callback;
+    r->userdata = userdata;
+    InitializeSRWLock(&r->lock);
+    if (!(r->thread = CreateThread(nullptr, 0, create_thread, r, 0, NULL))) {
+        av_free(r->url);
+        av_free(r);
+        return PLAYER_ERR_FAILED_CREATE_THREAD;
+    }
+    *request = r;
+    return PLAYER_ERR_OK;
+}
+
+void player_cancel_create(PlayerCreateRequest* request) {
+    if (!request) return;
+    AcquireSRWLockExclusive(&request->lock);
+    request->cancelled = 1;
+    if (request->session) request->session->interrupted = 1;
+    ReleaseSRWLockExclusive(&request->lock);
+}
+
+void player_free_create_request(PlayerCreateRequest** request) {
+    if (!request || !*request) return;
+    PlayerCreateRequest* r = *request;
+    player_cancel_create(r);
+    WaitForSingleObject(r->thread, INFINITE);
+    CloseHandle(r->thread);
+    av_free(r->url);
+    av_freep(request);
+}
+
 void player_free(PlayerSession** session) {
     if (!session) return;
     auto s = *session;
     if (!s) return;
-    if (s->has_audio && s->device_id) SDL_CloseAudioDevice(s->device_id);
+    close_audio_output(s);
     s->stoping = 1;
-    SDL_Event evt;
-    evt.type = FF_QUIT_EVENT;
-    SDL_PushEvent(&evt);
+    wake_decode_loop(s);
     if (s->event_thread) {
+        SDL_Event evt;
+        memset(&evt, 0, sizeof(SDL_Event));
+        evt.type = FF_QUIT_EVENT;
+        evt.user.data1 = s;
+        SDL_PushEvent(&evt);
+        wake_event_loop(s);
         DWORD status;
         while (GetExitCodeThread(s->event_thread, &status)) {
             if (status == STILL_ACTIVE) {
@@ -204,12 +571,15 @@ void player_free(PlayerSession** session) {
                 break;
             }
         }
+        drop_session_events(s);
+    }
+    for (int i = 0; i < VIDEO_TEXTURE_COUNT; i++) {
+        if (s->textures[i]) SDL_DestroyTexture(s->textures[i]);
     }
     if (s->renderer) SDL_DestroyRenderer(s->renderer);
-    if (s->texture) SDL_DestroyTexture(s->texture);
     if (!s->is_external_window && s->window) SDL_DestroyWindow(s->window);
     if (s->sdl_initialized) {
-        SDL_QuitSubSystem(SDL_INIT_AUDIO | SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_EVENTS);
+        SDL_QuitSubSystem(s->sdl_init_flags);
     }
     if (s->decode_thread) {
         DWORD status;
@@ -223,6 +593,7 @@ void player_free(PlayerSession** session) {
             }
         }
     }
+    free_next_item(s);
     if (s->buffer) av_audio_fifo_free(s->buffer);
     if (s->video_buffer) {
         size_t can_read = 0;
@@ -235,20 +606,326 @@ void player_free(PlayerSession** session) {
         }
         av_fifo_freep2(&s->video_buffer);
     }
+    free_video_packets(s);
+    free_filters(s);
     if (s->swrac) swr_free(&s->swrac);
     if (s->sws) sws_freeContext(s->sws);
+    av_frame_free(&s->cover_frame);
+    av_frame_free(&s->pending_cover);
+    av_frame_free(&s->display_frame);
     if (s->video_decoder) avcodec_free_context(&s->video_decoder);
     if (s->audio_decoder) avcodec_free_context(&s->audio_decoder);
     if (s->fmt) avformat_close_input(&s->fmt);
+    seek_index_free(&s->seek_index_builder);
     if (s->settings_is_alloc) {
         player_settings_free(&s->settings);
     }
     if (s->mutex) CloseHandle(s->mutex);
     if (s->video_mutex) CloseHandle(s->video_mutex);
+    if (s->decode_event) CloseHandle(s->decode_event);
+    if (s->event_wakeup) CloseHandle(s->event_wakeup);
+    if (s->decode_parked_event) CloseHandle(s->decode_parked_event);
     free(s);
     *session = nullptr;
 }
 
+int player_open(PlayerSession* session, const char* url) {
+    if (!session || !url) return PLAYER_ERR_NULLPTR;
+    player_pause(session);
+    // 暂停解码线程，之后可以安全地替换解码相关的数据
+    // 先清除上一次请求留下的标志，否则连续调用时解码线程还没重新开始就会被当作已暂停
+    session->decode_parked = 0;
+    MemoryBarrier();
+    session->decode_pause_requested = 1;
+    wake_decode_loop(session);
+    if (session->decode_thread) {
+        // 事件可能是之前暂停时留下的，每次唤醒后重新检查标志；解码线程退出时不再等待
+        HANDLE handles[2] = { session->decode_parked_event, session->decode_thread };
+        while (!session->decode_parked) {
+            if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0) break;
+        }
+    }
+    // 还没有切换的预加载文件不再需要
+    free_next_item(session);
+    int re = open_item(session, url);
+    if (!re) {
+        session->have_err = 0;
+        session->err = PLAYER_ERR_OK;
+        av_log(nullptr, AV_LOG_VERBOSE, "Opened \"%s\" in the existing session.\n", url);
+    }
+    session->decode_pause_requested = 0;
+    wake_decode_loop(session);
+    return re;
+}
+
+int player_enqueue_next(PlayerSession* session, const char* url) {
+    if (!session || !url) return PLAYER_ERR_NULLPTR;
+    int re = enqueue_next_item(session, url);
+    // 当前文件可能已解码完毕，解码线程需要开始等待预加载
+    if (!re) wake_decode_loop(session);
+    return re;
+}
+
+int player_has_next(PlayerSession* session) {
+    if (!session) return 0;
+    return session->next ? 1 : 0;
+}
+
+uint64_t player_get_item_index(PlayerSession* session) {
+    if (!session) return 0;
+    return session->item_index;
+}
+
+static int64_t get_latency(PlayerSession* session) {
+    if (session->has_audio) {
+        if (session->first_pts == INT64_MIN) return 0;
+        int64_t audio_diff = session->is_playing && session->last_pts_timestamp != INT64_MIN ? av_gettime() - session->last_pts_timestamp : 0;
+        // 加上音频设备缓冲区的时长
+        return session->last_pkt_pts - session->first_pts - session->pts - audio_diff + session->audio_device_latency;
+    }
+    if (session->video_first_pts == INT64_MIN) return 0;
+    return session->last_pkt_pts - session->video_first_pts - get_master_clock(session, av_gettime(), nullptr, nullptr);
+}
+
+int player_get_audio_device_latency(PlayerSession* session, int64_t* latency) {
+    if (!session || !latency) return PLAYER_ERR_NULLPTR;
+    if (!session->has_audio) return PLAYER_ERR_NO_STREAM_OR_DECODER;
+    *latency = session->audio_device_latency;
+    return PLAYER_ERR_OK;
+}
+
+int player_get_stats(PlayerSession* session, PlayerStats* stats) {
+    if (!session || !stats) return PLAYER_ERR_NULLPTR;
+    memset(stats, 0, sizeof(PlayerStats));
+    stats->video_skip_level = session->applied_video_skip_level;
+    stats->video_skipped_decodes = session->video_skipped_decodes;
+    stats->video_dropped_frames = session->video_dropped_frames;
+    stats->video_repeated_frames = session->video_repeated_frames;
+    stats->decode_wakeups = session->decode_wakeups;
+    stats->event_wakeups = session->event_wakeups;
+    stats->latency = get_latency(session);
+    stats->live_dropped_samples = session->live_dropped_samples;
+    stats->video_buffered_packets_duration = session->video_packets_duration;
+    stats->video_buffered_packets_size = session->video_packets_size;
+    if (session->video_buffer) stats->video_buffered_frames = av_fifo_can_read(session->video_buffer);
+    stats->video_bytes_saved_per_frame = session->video_bytes_saved_per_frame;
+    stats->video_bytes_saved = session->video_bytes_saved;
+    stats->audio_mix_time = session->mixer_time;
+    stats->audio_mix_calls = session->mixer_calls;
+    stats->audio_buffer_size = get_audio_buffer_size(session);
+    stats->video_buffer_size = get_video_buffer_size(session);
+    stats->audio_underruns = session->audio_underruns;
+    stats->video_stalls = session->video_stalls;
+    AcquireSRWLockShared(&session->buffer_adjustment_lock);
+    stats->buffer_adjustments = session->buffer_adjustment_count;
+    ReleaseSRWLockShared(&session->buffer_adjustment_lock);
+    return PLAYER_ERR_OK;
+}
+
+int player_get_pacing_stats(PlayerSession* session, PlayerPacingStats* stats) {
+    if (!session || !stats) return PLAYER_ERR_NULLPTR;
+    AcquireSRWLockShared(&session->pacing_lock);
+    memcpy(stats, &session->pacing, sizeof(PlayerPacingStats));
+    ReleaseSRWLockShared(&session->pacing_lock);
+    return PLAYER_ERR_OK;
+}
+
+void player_reset_pacing_stats(PlayerSession* session) {
+    if (!session) return;
+    AcquireSRWLockExclusive(&session->pacing_lock);
+    memset(&session->pacing, 0, sizeof(PlayerPacingStats));
+    session->pacing.last_present_time = INT64_MIN;
+    ReleaseSRWLockExclusive(&session->pacing_lock);
+}
+
+int player_get_presentations(PlayerSession* session, PlayerPresentation* entries, int max) {
+    if (!session || !entries || max <= 0) return 0;
+    AcquireSRWLockShared(&session->pacing_lock);
+    uint64_t total = session->pacing.presented_frames;
+    int count = (int)FFMIN(FFMIN(total, (uint64_t)PLAYER_PRESENTATION_LOG_SIZE), (uint64_t)max);
+    for (int i = 0; i < count; i++) {
+        entries[i] = session->presentations[(total - count + i) % PLAYER_PRESENTATION_LOG_SIZE];
+    }
+    ReleaseSRWLockShared(&session->pacing_lock);
+    return count;
+}
+
+int player_get_buffer_adjustments(PlayerSession* session, PlayerBufferAdjustment* entries, int max) {
+    if (!session || !entries || max <= 0) return 0;
+    AcquireSRWLockShared(&session->buffer_adjustment_lock);
+    uint64_t total = session->buffer_adjustment_count;
+    int count = (int)FFMIN(FFMIN(total, (uint64_t)PLAYER_BUFFER_ADJUSTMENT_LOG_SIZE), (uint64_t)max);
+    for (int i = 0; i < count; i++) {
+        entries[i] = session->buffer_adjustments[(total - count + i) % PLAYER_BUFFER_ADJUSTMENT_LOG_SIZE];
+    }
+    ReleaseSRWLockShared(&session->buffer_adjustment_lock);
+    return count;
+}
+
+int player_get_init_stats(PlayerSession* session, PlayerInitStats* stats) {
+    if (!session || !stats) return PLAYER_ERR_NULLPTR;
+    memcpy(stats, &session->init_stats, sizeof(PlayerInitStats));
+    return PLAYER_ERR_OK;
+}
+
+void player_get_probe_cache_stats(uint64_t* hits, uint64_t* misses) {
+    probe_cache_get_stats(hits, misses);
+}
+
+int player_set_gain(PlayerSession* session, float gain) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    session->mixer_gain = FFMIN(FFMAX(gain, 0.0f), 4.0f);
+    return PLAYER_ERR_OK;
+}
+
+int player_set_mute(PlayerSession* session, unsigned char mute) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    session->mixer_mute = mute ? 1 : 0;
+    return PLAYER_ERR_OK;
+}
+
+int player_set_solo(PlayerSession* session, unsigned char solo) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    session->mixer_solo = solo ? 1 : 0;
+    return PLAYER_ERR_OK;
+}
+
+int player_get_thread_info(PlayerSession* session, int thread, PlayerThreadInfo* info) {
+    if (!session || !info) return PLAYER_ERR_NULLPTR;
+    if (thread < 0 || thread >= PLAYER_THREAD_COUNT) return PLAYER_ERR_INVALID_ARGUMENT;
+    memcpy(info, &session->thread_info[thread], sizeof(PlayerThreadInfo));
+    return PLAYER_ERR_OK;
+}
+
+void player_trace_start() {
+    trace_start();
+}
+
+void player_trace_stop() {
+    trace_stop();
+}
+
+int player_trace_dump(const char* path) {
+    if (!path) return PLAYER_ERR_NULLPTR;
+    return trace_dump(path);
+}
+
+int player_get_mixer_stats(PlayerMixerStats* stats) {
+    if (!stats) return PLAYER_ERR_NULLPTR;
+    mixer_get_stats(stats);
+    return PLAYER_ERR_OK;
+}
+
+int player_get_stream_count(PlayerSession* session) {
+    if (!session || !session->fmt) return 0;
+    // 切换文件时会替换 fmt
+    if (WaitForSingleObject(session->mutex, INFINITE) != WAIT_OBJECT_0) return 0;
+    int count = session->fmt->nb_streams;
+    ReleaseMutex(session->mutex);
+    return count;
+}
+
+/// @brief 填充流信息，需要持有 session->mutex
+static int get_stream_info(PlayerSession* session, int index, PlayerStreamInfo* info) {
+    if (index < 0 || (unsigned int)index >= session->fmt->nb_streams) return PLAYER_ERR_INVALID_STREAM;
+    AVStream* is = session->fmt->streams[index];
+    AVCodecParameters* par = is->codecpar;
+    memset(info, 0, sizeof(PlayerStreamInfo));
+    info->index = index;
+    info->type = par->codec_type;
+    auto codec = avcodec_find_decoder(par->codec_id);
+    if (codec) av_strlcpy(info->codec, codec->name, sizeof(info->codec));
+    auto tag = av_dict_get(is->metadata, "language", nullptr, 0);
+    if (tag) av_strlcpy(info->language, tag->value, sizeof(info->language));
+    tag = av_dict_get(is->metadata, "title", nullptr, 0);
+    if (tag) av_strlcpy(info->title, tag->value, sizeof(info->title));
+    if (par->codec_type == AVMEDIA_TYPE_AUDIO) {
+        info->channels = par->ch_layout.nb_channels;
+        info->sample_rate = par->sample_rate;
+    } else if (par->codec_type == AVMEDIA_TYPE_VIDEO) {
+        info->width = par->width;
+        info->height = par->height;
+    }
+    info->bit_rate = par->bit_rate;
+    info->is_default = (is->disposition & AV_DISPOSITION_DEFAULT) ? 1 : 0;
+    info->is_selected = (session->has_audio && is == session->audio_input_stream) || (session->has_video && is == session->video_input_stream) || (session->has_cover && is == session->cover_stream);
+    info->is_attached_pic = (is->disposition & AV_DISPOSITION_ATTACHED_PIC) ? 1 : 0;
+    return PLAYER_ERR_OK;
+}
+
+int player_get_stream_info(PlayerSession* session, int index, PlayerStreamInfo* info) {
+    if (!session || !info) return PLAYER_ERR_NULLPTR;
+    // 切换文件或音轨时会替换 fmt 和选择的流
+    if (WaitForSingleObject(session->mutex, INFINITE) != WAIT_OBJECT_0) return PLAYER_ERR_WAIT_MUTEX_FAILED;
+    int re = get_stream_info(session, index, info);
+    ReleaseMutex(session->mutex);
+    return re;
+}
+
+int player_select_audio_stream(PlayerSession* session, int index) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    // 没有音频流时音频设备没有打开，只能在创建前通过设置选择
+    if (!session->has_audio) return PLAYER_ERR_NO_STREAM_OR_DECODER;
+    if (WaitForSingleObject(session->mutex, INFINITE) != WAIT_OBJECT_0) return PLAYER_ERR_WAIT_MUTEX_FAILED;
+    int re = PLAYER_ERR_OK;
+    if (index < 0 || (unsigned int)index >= session->fmt->nb_streams) {
+        re = PLAYER_ERR_INVALID_STREAM;
+    } else {
+        AVStream* is = session->fmt->streams[index];
+        if (is->codecpar->codec_type != AVMEDIA_TYPE_AUDIO || !avcodec_find_decoder(is->codecpar->codec_id)) re = PLAYER_ERR_INVALID_STREAM;
+    }
+    ReleaseMutex(session->mutex);
+    if (re) return re;
+    InterlockedExchange(&session->requested_audio_stream, index);
+    wake_decode_loop(session);
+    return PLAYER_ERR_OK;
+}
+
+int player_render_to_file(const char* url, PlayerSettings* settings, const char* audio_path, const char* video_path, PlayerRenderResult* result) {
+    if (!url) return PLAYER_ERR_NULLPTR;
+    PlayerSession* ses = nullptr;
+    FILE* audio_file = nullptr;
+    FILE* video_file = nullptr;
+    int re = session_open(url, &ses, settings);
+    if (re) return re;
+    if ((re = init_offline_audio_output(ses))) {
+        goto end;
+    }
+    if ((re = init_video_buffer(ses))) {
+        goto end;
+    }
+    if (audio_path && ses->has_audio) {
+        if (!(audio_file = fileop::fopen(audio_path, "wb"))) {
+            av_log(nullptr, AV_LOG_ERROR, "Failed to open \"%s\".\n", audio_path);
+            re = PLAYER_ERR_OPEN_FILE;
+            goto end;
+        }
+    }
+    if (video_path && ses->has_video) {
+        if (!(video_file = fileop::fopen(video_path, "wb"))) {
+            av_log(nullptr, AV_LOG_ERROR, "Failed to open \"%s\".\n", video_path);
+            re = PLAYER_ERR_OPEN_FILE;
+            goto end;
+        }
+    }
+    re = render_session(ses, audio_file, video_file, result);
+end:
+    if (audio_file) fileop::fclose(audio_file);
+    if (video_file) fileop::fclose(video_file);
+    player_free(&ses);
+    return re;
+}
+
+int player_extract_thumbnails(const char* url, int count, int width, int height, PlayerThumbnailCallback callback, void* userdata) {
+    if (!url || !callback) return PLAYER_ERR_NULLPTR;
+    return extract_thumbnails(url, count, width, height, callback, userdata);
+}
+
+int player_extract_thumbnails_batch(const char** urls, int url_count, int count, int width, int height, PlayerThumbnailCallback callback, void* userdata, int threads) {
+    if (!urls || !callback) return PLAYER_ERR_NULLPTR;
+    return extract_thumbnails_batch(urls, url_count, count, width, height, callback, userdata, threads);
+}
+
 void play(const char* filename, void** hWnd) {
     PlayerSettings* settings = player_settings_init();
     if (!settings) return;
@@ -290,8 +967,19 @@ void player_settings_default(PlayerSettings* settings) {
     if (!settings) return;
     memset(settings, 0, sizeof(PlayerSettings));
     settings->resize = 1;
+    settings->frame_skip = 1;
+    settings->vsync = 1;
     settings->audio_buffer_size = 1000;
     settings->video_buffer_size = 1000;
+    settings->video_buffer_bytes = 32 * 1024 * 1024;
+    settings->video_frame_lookahead = 4;
+    settings->target_latency = 50;
+    settings->speed = 1.0;
+    settings->audio_stream_index = PLAYER_STREAM_AUTO;
+    settings->video_stream_index = PLAYER_STREAM_AUTO;
+    for (int i = 0; i < PLAYER_THREAD_COUNT; i++) {
+        settings->thread_numa_node[i] = -1;
+    }
 }
 
 void player_settings_set_resize(PlayerSettings* settings, unsigned char resize) {
@@ -309,10 +997,26 @@ void player_settings_set_video_buffer_size(PlayerSettings* settings, uint32_t si
     settings->video_buffer_size = size;
 }
 
+void player_settings_set_video_buffer_bytes(PlayerSettings* settings, uint32_t bytes) {
+    if (!settings) return;
+    settings->video_buffer_bytes = bytes;
+}
+
+void player_settings_set_video_frame_lookahead(PlayerSettings* settings, uint32_t frames) {
+    if (!settings) return;
+    settings->video_frame_lookahead = frames;
+}
+
 void player_settings_free(PlayerSettings** settings) {
     if (!settings) return;
     auto s = *settings;
     if (!s) return;
+    if (s->input_format) free(s->input_format);
+    if (s->audio_filter) free(s->audio_filter);
+    if (s->audio_device) free(s->audio_device);
+    if (s->video_filter) free(s->video_filter);
+    if (s->probe_cache) free(s->probe_cache);
+    if (s->seek_index) free(s->seek_index);
     free(s);
     *settings = nullptr;
 }
@@ -374,8 +1078,139 @@ void player_settings_set_hWnd(PlayerSettings* settings, void** hWnd) {
     settings->hWnd = hWnd;
 }
 
+void player_settings_set_frame_skip(PlayerSettings* settings, unsigned char enable) {
+    if (!settings) return;
+    settings->frame_skip = enable;
+}
+
+static int set_settings_string(char** dest, const char* value) {
+    char* tmp = nullptr;
+    if (value && !cpp2c::string2char(value, tmp)) {
+        return PLAYER_ERR_OOM;
+    }
+    if (*dest) free(*dest);
+    *dest = tmp;
+    return PLAYER_ERR_OK;
+}
+
+void player_settings_set_low_latency(PlayerSettings* settings, unsigned char enable) {
+    if (!settings) return;
+    settings->low_latency = enable;
+}
+
+void player_settings_set_target_latency(PlayerSettings* settings, uint32_t latency) {
+    if (!settings) return;
+    settings->target_latency = latency;
+}
+
+int player_settings_set_input_format(PlayerSettings* settings, const char* format) {
+    if (!settings) return PLAYER_ERR_NULLPTR;
+    return set_settings_string(&settings->input_format, format);
+}
+
+int player_settings_set_audio_filter(PlayerSettings* settings, const char* filter) {
+    if (!settings) return PLAYER_ERR_NULLPTR;
+    return set_settings_string(&settings->audio_filter, filter);
+}
+
+int player_settings_set_video_filter(PlayerSettings* settings, const char* filter) {
+    if (!settings) return PLAYER_ERR_NULLPTR;
+    return set_settings_string(&settings->video_filter, filter);
+}
+
+void player_settings_set_speed(PlayerSettings* settings, double speed) {
+    if (!settings) return;
+    settings->speed = FFMIN(FFMAX(speed, PLAYER_MIN_SPEED), PLAYER_MAX_SPEED);
+}
+
+void player_settings_set_audio_period(PlayerSettings* settings, uint16_t samples) {
+    if (!settings) return;
+    settings->audio_period = samples;
+}
+
+int player_settings_set_audio_device(PlayerSettings* settings, const char* device) {
+    if (!settings) return PLAYER_ERR_NULLPTR;
+    return set_settings_string(&settings->audio_device, device);
+}
+
+void player_settings_set_audio_allowed_changes(PlayerSettings* settings, int allowed_changes) {
+    if (!settings) return;
+    settings->audio_allowed_changes = allowed_changes;
+}
+
+void player_settings_set_vsync(PlayerSettings* settings, unsigned char enable) {
+    if (!settings) return;
+    settings->vsync = enable ? 1 : 0;
+}
+
+void player_settings_set_audio_stream(PlayerSettings* settings, int index) {
+    if (!settings) return;
+    settings->audio_stream_index = index;
+}
+
+void player_settings_set_video_stream(PlayerSettings* settings, int index) {
+    if (!settings) return;
+    settings->video_stream_index = index;
+}
+
+int player_settings_set_probe_cache(PlayerSettings* settings, const char* dir) {
+    if (!settings) return PLAYER_ERR_NULLPTR;
+    return set_settings_string(&settings->probe_cache, dir);
+}
+
+void player_settings_set_shared_audio_output(PlayerSettings* settings, unsigned char enable) {
+    if (!settings) return;
+    settings->shared_audio_output = enable ? 1 : 0;
+}
+
+int player_settings_set_thread_priority(PlayerSettings* settings, int thread, int priority) {
+    if (!settings) return PLAYER_ERR_NULLPTR;
+    if (thread < 0 || thread >= PLAYER_THREAD_COUNT) return PLAYER_ERR_INVALID_ARGUMENT;
+    settings->thread_priority[thread] = FFMIN(FFMAX(priority, PLAYER_THREAD_PRIORITY_DEFAULT), PLAYER_THREAD_PRIORITY_REALTIME);
+    return PLAYER_ERR_OK;
+}
+
+int player_settings_set_thread_affinity(PlayerSettings* settings, int thread, uint64_t mask) {
+    if (!settings) return PLAYER_ERR_NULLPTR;
+    if (thread < 0 || thread >= PLAYER_THREAD_COUNT) return PLAYER_ERR_INVALID_ARGUMENT;
+    settings->thread_affinity[thread] = mask;
+    return PLAYER_ERR_OK;
+}
+
+int player_settings_set_thread_numa_node(PlayerSettings* settings, int thread, int node) {
+    if (!settings) return PLAYER_ERR_NULLPTR;
+    if (thread < 0 || thread >= PLAYER_THREAD_COUNT) return PLAYER_ERR_INVALID_ARGUMENT;
+    settings->thread_numa_node[thread] = node < 0 ? -1 : node;
+    return PLAYER_ERR_OK;
+}
+
+int player_settings_set_seek_index(PlayerSettings* settings, const char* dir) {
+    if (!settings) return PLAYER_ERR_NULLPTR;
+    return set_settings_string(&settings->seek_index, dir);
+}
+
+int player_settings_set_adaptive_buffer(PlayerSettings* settings, uint32_t min, uint32_t max) {
+    if (!settings) return PLAYER_ERR_NULLPTR;
+    if (max && (!min || min > max)) return PLAYER_ERR_INVALID_ARGUMENT;
+    settings->adaptive_buffer_min = max ? min : 0;
+    settings->adaptive_buffer_max = max;
+    return PLAYER_ERR_OK;
+}
+
+int player_build_seek_index(const char* url, const char* dir) {
+    if (!url || !dir) return PLAYER_ERR_NULLPTR;
+    PlayerSettings* settings = player_settings_init();
+    if (!settings) return PLAYER_ERR_OOM;
+    int re = player_settings_set_seek_index(settings, dir);
+    if (!re) re = build_seek_index(url, settings);
+    player_settings_free(&settings);
+    return re;
+}
+
 int wait_player_inited(PlayerSession* session) {
     if (!session) return PLAYER_ERR_NULLPTR;
+    // 纯音频文件没有视频输出需要初始化
+    if (!session->has_video) return session->err;
     while (!session->video_is_init) {
         Sleep(10);
     }
@@ -385,9 +1220,11 @@ int wait_player_inited(PlayerSession* session) {
 int player_play(PlayerSession* session) {
     if (!session) return PLAYER_ERR_NULLPTR;
     if (session->is_playing) return PLAYER_ERR_OK;
+    if (!session->has_audio) session->clock_start_timestamp = av_gettime() - session->clock_paused_pos;
     session->is_playing = 1;
-    if (session->has_audio) SDL_PauseAudioDevice(session->device_id, 0);
-    if (session->has_video) video_refresh_timer(session);
+    if (session->has_audio) set_audio_output_paused(session, 0);
+    if (session->has_video) request_video_refresh(session);
+    wake_decode_loop(session);
     return PLAYER_ERR_OK;
 }
 
@@ -395,7 +1232,12 @@ int player_pause(PlayerSession* session) {
     if (!session) return PLAYER_ERR_NULLPTR;
     if (!session->is_playing) return PLAYER_ERR_OK;
     session->is_playing = 0;
-    if (session->has_audio) SDL_PauseAudioDevice(session->device_id, 1);
+    if (session->has_audio) set_audio_output_paused(session, 1);
+    else session->clock_paused_pos = av_gettime() - session->clock_start_timestamp;
+    // 暂停的时间不计入帧间隔
+    AcquireSRWLockExclusive(&session->pacing_lock);
+    session->pacing.last_present_time = INT64_MIN;
+    ReleaseSRWLockExclusive(&session->pacing_lock);
     return PLAYER_ERR_OK;
 }
 
@@ -412,6 +1254,9 @@ int player_get_duration(PlayerSession* session, int64_t* duration) {
         *duration = session->audio_input_stream->duration;
     } else if (session->has_video && session->video_input_stream->duration != AV_NOPTS_VALUE) {
         *duration = session->video_input_stream->duration;
+    } else if (session->seek_index_duration > 0) {
+        // 容器中没有时长，使用跳转索引记录的时长
+        *duration = session->seek_index_duration;
     } else {
         return PLAYER_ERR_NO_DURATION;
     }
@@ -437,16 +1282,18 @@ char* player_ts_make_string(char* buf, int64_t ts) {
 int player_buffer_is_full(PlayerSession* session) {
     if (!session) return 0;
     if (session->has_audio && session->has_video) {
-        return av_audio_fifo_size(session->buffer) >= session->needed_audio_samples && !av_fifo_can_write(session->video_buffer) ? 1 : 0;
+        return av_audio_fifo_size(session->buffer) >= session->needed_audio_samples && !av_fifo_can_write(session->video_buffer) && (session->demux_is_eof || packet_buffer_is_full(session)) ? 1 : 0;
     } else if (session->has_audio) {
         return av_audio_fifo_size(session->buffer) >= session->needed_audio_samples ? 1 : 0;
     } else if (session->has_video) {
-        return !av_fifo_can_write(session->video_buffer) ? 1 : 0;
+        return !av_fifo_can_write(session->video_buffer) && (session->demux_is_eof || packet_buffer_is_full(session)) ? 1 : 0;
     }
 }
 
 void player_wait_until_buffer_is_full(PlayerSession* session) {
     if (!session) return;
+    // 低延迟模式下不等待缓冲区填满
+    if (session->settings->low_latency) return;
     while (!player_buffer_is_full(session)) {
         Sleep(1);
     }
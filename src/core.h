@@ -10,13 +10,18 @@ extern "C" {
 #include "libavformat/avformat.h"
 #include "libavcodec/avcodec.h"
 #include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+#include "libavdevice/avdevice.h"
 #include "libavutil/avutil.h"
 #include "libswresample/swresample.h"
 #include "libavutil/audio_fifo.h"
 #include "libavutil/fifo.h"
 #include "libavutil/time.h"
+#include "libavutil/avstring.h"
 #include "libavutil/timestamp.h"
 #include "libswscale/swscale.h"
+#include "libavutil/imgutils.h"
 #ifdef __cplusplus
 }
 #endif
@@ -25,16 +30,61 @@ extern "C" {
 
 #define FF_REFRESH_EVENT (SDL_USEREVENT)
 #define FF_QUIT_EVENT (SDL_USEREVENT + 1)
+/// @brief 轮流使用的视频纹理数量
+#define VIDEO_TEXTURE_COUNT 3
 
 typedef struct PlayerSettings {
     /// @brief HWND
     void** hWnd;
     /// @brief 是否自动调节窗口大小
     unsigned char resize: 1;
+    /// @brief 播放落后时是否让解码器跳帧
+    unsigned char frame_skip: 1;
+    /// @brief 是否开启垂直同步
+    unsigned char vsync: 1;
+    /// @brief 是否使用多个会话共享的混音器输出音频
+    unsigned char shared_audio_output: 1;
     /// @brief 音频缓冲区大小（单位 ms）
     uint32_t audio_buffer_size;
-    /// @brief 视频缓冲区大小（单位 ms）
+    /// @brief 视频数据包缓冲区大小（单位 ms）
     uint32_t video_buffer_size;
+    /// @brief 视频数据包缓冲区的最大字节数
+    uint32_t video_buffer_bytes;
+    /// @brief 预先解码的视频帧数
+    uint32_t video_frame_lookahead;
+    /// @brief 低延迟模式下的目标延迟（单位 ms）
+    uint32_t target_latency;
+    /// @brief 指定输入格式（如 lavfi），为NULL时自动检测
+    char* input_format;
+    /// @brief 是否启用低延迟模式（用于直播流）
+    unsigned char low_latency : 1;
+    /// @brief 音频滤镜（FFmpeg 滤镜语法），为NULL时不使用
+    char* audio_filter;
+    /// @brief 视频滤镜（FFmpeg 滤镜语法），为NULL时不使用
+    char* video_filter;
+    /// @brief 播放速度（0.5 - 4.0）
+    double speed;
+    /// @brief 音频设备每次回调的样本数，为0时使用 10ms
+    uint16_t audio_period;
+    /// @brief 音频设备名称，为NULL时使用默认设备
+    char* audio_device;
+    /// @brief 允许音频设备使用与请求不同的格式（SDL_AUDIO_ALLOW_*）
+    int audio_allowed_changes;
+    /// @brief 指定的音频流序号，-1 为自动选择，PLAYER_STREAM_DISABLED 为禁用
+    int audio_stream_index;
+    /// @brief 指定的视频流序号，-1 为自动选择，PLAYER_STREAM_DISABLED 为禁用
+    int video_stream_index;
+    /// @brief 探测缓存目录，为NULL时不使用
+    char* probe_cache;
+    /// @brief 跳转索引目录，为NULL时不使用
+    char* seek_index;
+    /// @brief 各线程的优先级（PLAYER_THREAD_PRIORITY_*）、CPU 亲和性掩码和 NUMA 节点（-1 为不绑定）
+    int thread_priority[PLAYER_THREAD_COUNT];
+    uint64_t thread_affinity[PLAYER_THREAD_COUNT];
+    int thread_numa_node[PLAYER_THREAD_COUNT];
+    /// @brief 自适应缓冲区的最小和最大大小（单位 ms），最大值为0时不使用
+    uint32_t adaptive_buffer_min;
+    uint32_t adaptive_buffer_max;
 } PlayerSettings;
 
 typedef struct PlayerSession {
@@ -61,18 +111,48 @@ typedef struct PlayerSession {
     HANDLE decode_thread;
     /// @brief 音频缓冲区
     AVAudioFifo* buffer;
+    /// @brief 已解码视频帧缓冲区（AVFrame*），只保留少量帧
     AVFifo* video_buffer;
+    /// @brief 视频数据包缓冲区（AVPacket*），用于深度缓冲
+    AVFifo* video_packets;
+    /// @brief 视频数据包缓冲区中数据的总时长（单位：微秒）
+    int64_t video_packets_duration;
+    /// @brief 视频数据包缓冲区中数据的总字节数
+    int64_t video_packets_size;
     /// @brief 音频输出格式
     enum AVSampleFormat target_format;
     /// @brief 每样本字节数
     int target_format_pbytes;
     /// @brief 音频设备 ID
     SDL_AudioDeviceID device_id;
+    /// @brief 音频设备缓冲区的延迟（单位：微秒）
+    int64_t audio_device_latency;
+    /// @brief 混音器中的音量
+    float mixer_gain;
+    /// @brief 上次混音结束时实际使用的音量，与 mixer_gain 不同时在一个周期内渐变
+    float mixer_applied_gain;
+    /// @brief 各线程实际应用的调度设置
+    PlayerThreadInfo thread_info[PLAYER_THREAD_COUNT];
+    /// @brief 各线程的 MMCSS 注册句柄
+    HANDLE mmcss_handles[PLAYER_THREAD_COUNT];
+    /// @brief 混音器处理该会话的累计耗时（单位：微秒）和次数
+    int64_t mixer_time;
+    uint64_t mixer_calls;
     /// @brief 错误码（来自FFmpeg或核心本身）
     int err;
     /// @brief 互斥锁，保护音频缓冲区和时间
     HANDLE mutex;
     HANDLE video_mutex;
+    /// @brief 唤醒空闲的解码线程（自动重置）
+    HANDLE decode_event;
+    /// @brief 唤醒事件线程（自动重置）
+    HANDLE event_wakeup;
+    /// @brief 解码线程暂停时通知 player_open（自动重置）
+    HANDLE decode_parked_event;
+    /// @brief 解码线程从等待中被唤醒的次数
+    uint64_t decode_wakeups;
+    /// @brief 事件线程从等待中被唤醒的次数
+    uint64_t event_wakeups;
     /// @brief 缓冲区开始时间
     int64_t pts;
     /// @brief 缓冲区结束时间
@@ -88,12 +168,50 @@ typedef struct PlayerSession {
     /// @brief SDL 窗口
     SDL_Window* window;
     SDL_Renderer* renderer;
-    SDL_Texture* texture;
+    /// @brief 轮流使用的流式纹理，上传一帧时可以同时转换下一帧
+    SDL_Texture* textures[VIDEO_TEXTURE_COUNT];
+    /// @brief 下一帧使用的纹理序号
+    int texture_index;
+    /// @brief 正在显示的帧的引用，释放锁后上传期间缓冲区被清空也不会释放该帧
+    AVFrame* display_frame;
+    /// @brief 已上传缓冲区第一帧的纹理，video_head_displayed 为 1 时有效
+    SDL_Texture* head_texture;
     uint32_t sdl_pixel_format;
     int window_width;
     int window_height;
     HANDLE event_thread;
     SwsContext* sws;
+    /// @brief 封面（附加图片）流，只在没有真正的视频流时使用
+    AVStream* cover_stream;
+    /// @brief 解码后的封面，每个文件只解码一次，只在事件线程中使用
+    AVFrame* cover_frame;
+    /// @brief 切换文件后等待事件线程换上的封面（NULL 为新文件没有封面），由 mutex 保护
+    AVFrame* pending_cover;
+    /// @brief pending_cover 已更新，由 mutex 保护（不使用位域）
+    unsigned char cover_changed;
+    /// @brief 音频滤镜
+    AVFilterGraph* audio_filter_graph;
+    AVFilterContext* audio_filter_src;
+    AVFilterContext* audio_filter_sink;
+    /// @brief 视频滤镜
+    AVFilterGraph* video_filter_graph;
+    AVFilterContext* video_filter_src;
+    AVFilterContext* video_filter_sink;
+    /// @brief 播放时请求切换到的音频流序号，-1 为无请求（用 InterlockedExchange 取出）
+    volatile LONG requested_audio_stream;
+    /// @brief 探测缓存中记录的上次自动选择的流序号，<0 为无记录
+    int cached_audio_stream;
+    int cached_video_stream;
+    /// @brief 正在记录的跳转索引，不需要建立索引时为NULL
+    struct SeekIndexBuilder* seek_index_builder;
+    /// @brief 跳转索引中记录的时长，0 为未知
+    int64_t seek_index_duration;
+    /// @brief 视频解码器的 lowres 参数（缩小 2^n 倍解码）
+    int video_lowres;
+    /// @brief 送入视频缓冲区的帧率（经过滤镜后）
+    AVRational video_frame_rate;
+    /// @brief 播放速度
+    AVRational speed;
     /// @brief 播放设置
     PlayerSettings* settings;
     /// @brief 缓冲区应有的音频样本数
@@ -102,11 +220,86 @@ typedef struct PlayerSession {
     uint64_t needed_video_frames;
     /// @brief 缓冲区的最大视频帧数
     uint64_t max_video_frames;
+    /// @brief 自适应缓冲区当前的大小（单位 ms）
+    uint32_t buffer_target;
+    /// @brief 音频回调时缓冲区数据不足的次数（由音频回调写入）
+    uint64_t audio_underruns;
+    /// @brief 需要显示视频时没有已解码帧的次数（由视频刷新线程写入）
+    uint64_t video_stalls;
+    /// @brief 上次调整缓冲区大小时看到的卡顿次数
+    uint64_t buffer_seen_underruns;
+    uint64_t buffer_seen_stalls;
+    /// @brief 上次增大缓冲区的时间和上次卡顿或调整的时间（av_gettime_relative）
+    int64_t buffer_last_grow;
+    int64_t buffer_last_change;
+    /// @brief 缓冲区大小的调整记录（环形缓冲区）
+    PlayerBufferAdjustment buffer_adjustments[PLAYER_BUFFER_ADJUSTMENT_LOG_SIZE];
+    uint64_t buffer_adjustment_count;
+    /// @brief 保护 buffer_adjustments 和 buffer_adjustment_count，解码线程写入，player_get_* 读取
+    SRWLOCK buffer_adjustment_lock;
     /// @brief 渲染下一帧视频数据的大致时间戳
     int64_t next_video_timestamp;
     /// @brief 上一次更新音频数据的时间戳
     int64_t last_pts_timestamp;
+    /// @brief 没有音频时，系统时钟对应播放位置0的时间戳
+    int64_t clock_start_timestamp;
+    /// @brief 没有音频时，暂停时的播放位置
+    int64_t clock_paused_pos;
+    /// @brief 已初始化的SDL子系统
+    uint32_t sdl_init_flags;
     SDL_DisplayMode sdl_display_mode;
+    /// @brief 期望的解码器跳帧等级（由视频刷新线程调整）
+    int video_skip_level;
+    /// @brief 已应用到解码器上的跳帧等级（仅解码线程使用）
+    int applied_video_skip_level;
+    /// @brief 连续丢帧的刷新次数
+    uint32_t skip_late_ticks;
+    /// @brief 连续未丢帧的刷新次数
+    uint32_t skip_ontime_ticks;
+    /// @brief 因跳帧而未发送给解码器的视频数据包数
+    uint64_t video_skipped_decodes;
+    /// @brief 已解码但被丢弃的视频帧数
+    uint64_t video_dropped_frames;
+    /// @brief 同一帧再次显示的次数（帧的时长跨过多次刷新）
+    uint64_t video_repeated_frames;
+    /// @brief 低延迟模式下因延迟过大而丢弃的音频样本数
+    uint64_t live_dropped_samples;
+    /// @brief 上一次垂直同步的时间（SDL_RenderPresent 返回的时间）
+    int64_t last_vsync_timestamp;
+    /// @brief 视频帧显示节奏统计
+    PlayerPacingStats pacing;
+    /// @brief 保护 pacing 和 presentations，显示线程写入，player_get_* 读取
+    SRWLOCK pacing_lock;
+    /// @brief 定时器请求刷新画面，由事件线程执行刷新
+    volatile LONG refresh_requested;
+    /// @brief 创建会话时各步骤的耗时
+    PlayerInitStats init_stats;
+    /// @brief 最近显示的帧的显示记录（环形缓冲区）
+    PlayerPresentation presentations[PLAYER_PRESENTATION_LOG_SIZE];
+    /// @brief 直接转换到纹理中，每帧节省的内存读写字节数
+    int64_t video_bytes_saved_per_frame;
+    /// @brief 直接转换到纹理中，总共节省的内存读写字节数
+    uint64_t video_bytes_saved;
+    /// @brief 预加载的下一个文件（仅使用 Demux 和解码器相关字段）
+    struct PlayerSession* next;
+    /// @brief 下一个文件的路径
+    char* next_url;
+    /// @brief 预加载线程
+    HANDLE preload_thread;
+    /// @brief 当前播放的是第几个文件（从0开始）
+    uint64_t item_index;
+    /// @brief 中断正在进行的读取（取消异步创建时设置）
+    volatile unsigned char interrupted;
+    /// @brief 请求解码线程暂停（不使用位域，避免与其他线程写入的标志位互相覆盖）
+    volatile unsigned char decode_pause_requested;
+    /// @brief 解码线程已暂停
+    volatile unsigned char decode_parked;
+    /// @brief 混音器是否输出该会话（由混音器回调读取）
+    volatile unsigned char mixer_playing;
+    volatile unsigned char mixer_mute;
+    volatile unsigned char mixer_solo;
+    /// @brief 使用共享的混音器输出音频
+    unsigned char use_mixer : 1;
     /// @brief 是否初始化了SDL
     unsigned char sdl_initialized : 1;
     /// 让事件处理线程退出标志位
@@ -126,6 +319,42 @@ typedef struct PlayerSession {
     unsigned char set_new_video_pts : 1;
     unsigned char is_external_window : 1;
     unsigned char video_is_init : 1;
+    /// 已读到文件尾部
+    unsigned char demux_is_eof : 1;
+    /// 已向视频解码器发送结束标志
+    unsigned char video_decoder_flushed : 1;
+    /// 跳过了非关键帧，下一个关键帧之前的数据包都不发送给解码器
+    unsigned char video_skip_until_key : 1;
+    /// 低延迟模式下正在加速播放以追赶延迟
+    unsigned char live_catching_up : 1;
+    /// 复用当前的解码器（仅用于 player_open 打开的文件）
+    unsigned char reuse_audio_decoder : 1;
+    unsigned char reuse_video_decoder : 1;
+    /// 视频缓冲区的第一帧已经显示过
+    unsigned char video_head_displayed : 1;
+    /// 流信息来自探测缓存
+    unsigned char probe_cache_hit : 1;
+    /// 视频解码器只解码关键帧
+    unsigned char keyframes_only : 1;
+    /// 显示封面（不经过视频解码和刷新）
+    unsigned char has_cover : 1;
+    /// 已向滤镜发送结束标志
+    unsigned char audio_filter_flushed : 1;
+    unsigned char video_filter_flushed : 1;
 } PlayerSession;
 
+typedef struct PlayerCreateRequest {
+    char* url;
+    PlayerSettings* settings;
+    PlayerCreateCallback callback;
+    void* userdata;
+    /// @brief 后台创建线程
+    HANDLE thread;
+    /// @brief 保护 cancelled 和 session
+    SRWLOCK lock;
+    unsigned char cancelled;
+    /// @brief 正在创建的会话，创建完成后为NULL
+    PlayerSession* session;
+} PlayerCreateRequest;
+
 #endif
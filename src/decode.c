@@ -1,4 +1,9 @@
 #include "decode.h"
+#include "filter.h"
+#include "audio_output.h"
+#include "seek_index.h"
+#include "trace.h"
+#include "adaptive_buffer.h"
 
 int open_audio_decoder(PlayerSession* session) {
     if (!session) return PLAYER_ERR_NULLPTR;
@@ -19,6 +24,10 @@ int open_audio_decoder(PlayerSession* session) {
         av_log(NULL, AV_LOG_ERROR, "Failed to copy audio codec parameters from input stream: %s (%d)\n", av_err2str(re), re);
         return re;
     }
+    if (session->settings->low_latency) {
+        session->audio_decoder->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        session->audio_decoder->flags2 |= AV_CODEC_FLAG2_FAST;
+    }
     if ((re = avcodec_open2(session->audio_decoder, session->audio_codec, NULL)) < 0) {
         av_log(NULL, AV_LOG_ERROR, "Failed to open audio decoder (%s): %s (%d)\n", session->audio_codec->name, av_err2str(re), re);
         return re;
@@ -46,6 +55,20 @@ int open_video_decoder(PlayerSession* session) {
         av_log(NULL, AV_LOG_ERROR, "Failed to copy video codec parameters from input stream: %s (%d)\n", av_err2str(re), re);
         return re;
     }
+    if (session->settings->low_latency) {
+        session->video_decoder->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        session->video_decoder->flags2 |= AV_CODEC_FLAG2_FAST;
+        // 帧级多线程会引入额外的帧延迟
+        session->video_decoder->thread_type = FF_THREAD_SLICE;
+    }
+    if (session->keyframes_only) {
+        // 只解码关键帧，逐帧解码时多线程只会增加延迟
+        session->video_decoder->skip_frame = AVDISCARD_NONKEY;
+        session->video_decoder->thread_count = 1;
+    }
+    if (session->video_lowres) {
+        session->video_decoder->lowres = FFMIN(session->video_lowres, session->video_codec->max_lowres);
+    }
     if ((re = avcodec_open2(session->video_decoder, session->video_codec, NULL)) < 0) {
         av_log(NULL, AV_LOG_ERROR, "Failed to open video decoder (%s): %s (%d)\n", session->video_codec->name, av_err2str(re), re);
         return re;
@@ -54,12 +77,51 @@ int open_video_decoder(PlayerSession* session) {
     return PLAYER_ERR_OK;
 }
 
+int decode_cover(PlayerSession* session) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    if (!session->cover_stream) return PLAYER_ERR_NO_STREAM_OR_DECODER;
+    AVStream* st = session->cover_stream;
+    const AVCodec* codec = avcodec_find_decoder(st->codecpar->codec_id);
+    if (!codec) return PLAYER_ERR_NO_STREAM_OR_DECODER;
+    // 解码器只使用一次，不保存在会话中
+    AVCodecContext* dec = avcodec_alloc_context3(codec);
+    AVFrame* frame = av_frame_alloc();
+    int re = 0;
+    if (!dec || !frame) {
+        re = PLAYER_ERR_OOM;
+        goto end;
+    }
+    if ((re = avcodec_parameters_to_context(dec, st->codecpar)) < 0) goto end;
+    dec->thread_count = 1;
+    if ((re = avcodec_open2(dec, codec, NULL)) < 0) goto end;
+    if ((re = avcodec_send_packet(dec, &st->attached_pic)) < 0) goto end;
+    if ((re = avcodec_send_packet(dec, NULL)) < 0) goto end;
+    if ((re = avcodec_receive_frame(dec, frame)) < 0) goto end;
+    av_log(NULL, AV_LOG_VERBOSE, "Cover decoded: %s %dx%d\n", codec->name, frame->width, frame->height);
+    session->cover_frame = frame;
+    frame = NULL;
+    re = PLAYER_ERR_OK;
+end:
+    if (re) av_log(NULL, AV_LOG_WARNING, "Failed to decode cover: %s (%i)\n", av_err2str(re), re);
+    av_frame_free(&frame);
+    avcodec_free_context(&dec);
+    return re;
+}
+
 int decode_audio_internal(PlayerSession* handle, char* writed, AVFrame* frame) {
     if (!handle || !writed || !frame) return PLAYER_ERR_NULLPTR;
     if (!handle->has_audio) return PLAYER_ERR_OK;
     if (!handle->audio_decoder) return PLAYER_ERR_NULLPTR;
     int re = 0;
+    if (handle->audio_filter_graph) {
+        // 先取出滤镜中已处理好的数据
+        if ((re = pull_audio_filter(handle, frame, writed)) || *writed || handle->audio_is_eof) {
+            goto end;
+        }
+    }
+    int64_t trace_start = TRACE_BEGIN();
     re = avcodec_receive_frame(handle->audio_decoder, frame);
+    TRACE_END("avcodec_receive_frame (audio)", trace_start, re >= 0 ? trace_ts(frame->pts, handle->audio_input_stream->time_base) : AV_NOPTS_VALUE);
     if (re >= 0) {
         if (handle->first_pts == INT64_MIN) {
             handle->first_pts = av_rescale_q_rnd(frame->pts, handle->audio_input_stream->time_base, AV_TIME_BASE_Q, AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
@@ -75,6 +137,13 @@ int decode_audio_internal(PlayerSession* handle, char* writed, AVFrame* frame) {
             // 跳过NOPTS的frame
             goto end;
         }
+        if (handle->audio_filter_graph) {
+            if ((re = push_audio_filter(handle, frame))) {
+                goto end;
+            }
+            re = pull_audio_filter(handle, frame, writed);
+            goto end;
+        }
         re = audio_convert_samples_and_add_to_fifo(handle, frame, writed);
         goto end;
     } else if (re == AVERROR(EAGAIN)) {
@@ -82,6 +151,14 @@ int decode_audio_internal(PlayerSession* handle, char* writed, AVFrame* frame) {
         re = PLAYER_ERR_OK;
         goto end;
     } else if (re == AVERROR_EOF) {
+        if (handle->audio_filter_graph) {
+            // 冲洗滤镜，滤镜输出结束后才算结束
+            if ((re = push_audio_filter(handle, NULL))) {
+                goto end;
+            }
+            re = pull_audio_filter(handle, frame, writed);
+            goto end;
+        }
         handle->audio_is_eof = 1;
         re = PLAYER_ERR_OK;
         goto end;
@@ -95,7 +172,15 @@ int decode_video_internal(PlayerSession* handle, char* writed, AVFrame* frame) {
     if (!handle->has_video) return PLAYER_ERR_OK;
     if (!handle->video_decoder) return PLAYER_ERR_NULLPTR;
     int re = 0;
+    if (handle->video_filter_graph) {
+        // 先取出滤镜中已处理好的数据
+        if ((re = pull_video_filter(handle, frame, writed)) || *writed || handle->video_is_eof) {
+            goto end;
+        }
+    }
+    int64_t trace_start = TRACE_BEGIN();
     re = avcodec_receive_frame(handle->video_decoder, frame);
+    TRACE_END("avcodec_receive_frame (video)", trace_start, re >= 0 ? trace_ts(frame->pts, handle->video_input_stream->time_base) : AV_NOPTS_VALUE);
     if (re >= 0) {
         if (handle->video_first_pts == INT64_MIN) {
             handle->video_first_pts = av_rescale_q_rnd(frame->pts, handle->video_input_stream->time_base, AV_TIME_BASE_Q, AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
@@ -111,6 +196,13 @@ int decode_video_internal(PlayerSession* handle, char* writed, AVFrame* frame) {
             // 跳过NOPTS的frame
             goto end;
         }
+        if (handle->video_filter_graph) {
+            if ((re = push_video_filter(handle, frame))) {
+                goto end;
+            }
+            re = pull_video_filter(handle, frame, writed);
+            goto end;
+        }
         re = video_add_to_fifo(handle, frame, writed);
         goto end;
     } else if (re == AVERROR(EAGAIN)) {
@@ -118,6 +210,14 @@ int decode_video_internal(PlayerSession* handle, char* writed, AVFrame* frame) {
         re = PLAYER_ERR_OK;
         goto end;
     } else if (re == AVERROR_EOF) {
+        if (handle->video_filter_graph) {
+            // 冲洗滤镜，滤镜输出结束后才算结束
+            if ((re = push_video_filter(handle, NULL))) {
+                goto end;
+            }
+            re = pull_video_filter(handle, frame, writed);
+            goto end;
+        }
         handle->video_is_eof = 1;
         re = PLAYER_ERR_OK;
         goto end;
@@ -143,12 +243,18 @@ int audio_convert_samples_and_add_to_fifo(PlayerSession* handle, AVFrame* frame,
         goto end;
     }
     memset(converted_input_samples, 0, sizeof(void*) * handle->sdl_spec.channels);
+    if (handle->settings->low_latency) {
+        control_live_latency(handle, frames);
+    }
     if ((re = av_samples_alloc(converted_input_samples, NULL, handle->sdl_spec.channels, frames, handle->target_format, 0)) < 0) {
         re = PLAYER_ERR_OOM;
         goto end;
     }
     re = 0;
-    if ((converted_samples = swr_convert(handle->swrac, converted_input_samples, frames, (const uint8_t**)frame->extended_data, samples)) < 0) {
+    int64_t trace_start = TRACE_BEGIN();
+    converted_samples = swr_convert(handle->swrac, converted_input_samples, frames, (const uint8_t**)frame->extended_data, samples);
+    TRACE_END("swr_convert", trace_start, trace_ts(frame->pts, handle->audio_input_stream->time_base));
+    if (converted_samples < 0) {
         re = converted_samples;
         goto end;
     }
@@ -193,6 +299,8 @@ int video_add_to_fifo(PlayerSession* handle, AVFrame* frame, char* writed) {
         re = PLAYER_ERR_WAIT_MUTEX_FAILED;
         return re;
     }
+    // 记录帧属于第几个文件，切换文件后缓冲区中上一个文件的帧使用不同的时间基
+    frame->opaque = (void*)(uintptr_t)handle->item_index;
     if ((re = av_fifo_write(handle->video_buffer, &frame, 1)) < 0) {
         ReleaseMutex(handle->video_mutex);
         av_log(NULL, AV_LOG_ERROR, "Failed to write video frame to buffer: %s (%i)\n", av_err2str(re), re);
@@ -206,10 +314,179 @@ end:
     return re;
 }
 
+/// @brief 将音频解码器和滤镜中已有的数据全部放入音频缓冲区
+static int drain_audio_decoder(PlayerSession* handle) {
+    AVFrame* frame = av_frame_alloc();
+    char writed = 0;
+    int re = PLAYER_ERR_OK;
+    if (!frame) return PLAYER_ERR_OOM;
+    do {
+        writed = 0;
+        re = decode_audio_internal(handle, &writed, frame);
+    } while (!re && writed && !handle->audio_is_eof);
+    av_frame_free(&frame);
+    return re;
+}
+
+/**
+ * @brief 数据包计入缓冲区的时长（单位：微秒）
+ *
+ * 放入和取出时必须使用同一个函数计算，保证减去的时长与加上的相同
+*/
+static int64_t video_packet_duration(PlayerSession* handle, const AVPacket* p) {
+    int64_t duration = p->duration;
+    if (duration <= 0) {
+        // 没有时长信息时按帧率估计
+        AVRational rate = av_guess_frame_rate(handle->fmt, handle->video_input_stream, NULL);
+        duration = rate.num && rate.den ? av_rescale_q(1, av_inv_q(rate), handle->video_input_stream->time_base) : 0;
+    }
+    return av_rescale_q(duration, handle->video_input_stream->time_base, AV_TIME_BASE_Q);
+}
+
+/// @brief 将视频数据包放入数据包缓冲区，会接管 pkt 中的引用
+static int put_video_packet(PlayerSession* handle, AVPacket* pkt) {
+    AVPacket* p = av_packet_alloc();
+    int re = 0;
+    if (!p) return PLAYER_ERR_OOM;
+    av_packet_move_ref(p, pkt);
+    int64_t duration = video_packet_duration(handle, p);
+    if ((re = av_fifo_write(handle->video_packets, &p, 1)) < 0) {
+        av_packet_free(&p);
+        return re;
+    }
+    handle->video_packets_duration += duration;
+    handle->video_packets_size += p->size;
+    return PLAYER_ERR_OK;
+}
+
+/// @brief 从数据包缓冲区取出一个视频数据包
+static AVPacket* get_video_packet(PlayerSession* handle) {
+    AVPacket* p = NULL;
+    if (av_fifo_read(handle->video_packets, &p, 1) < 0) return NULL;
+    int64_t duration = video_packet_duration(handle, p);
+    if (!av_fifo_can_read(handle->video_packets)) {
+        handle->video_packets_duration = 0;
+        handle->video_packets_size = 0;
+    } else {
+        handle->video_packets_duration = FFMAX(handle->video_packets_duration - duration, 0);
+        handle->video_packets_size -= p->size;
+    }
+    return p;
+}
+
+void flush_video_packets(PlayerSession* handle) {
+    if (!handle || !handle->video_packets) return;
+    AVPacket* p = NULL;
+    while (av_fifo_read(handle->video_packets, &p, 1) >= 0) {
+        av_packet_free(&p);
+    }
+    handle->video_packets_duration = 0;
+    handle->video_packets_size = 0;
+}
+
+void free_video_packets(PlayerSession* handle) {
+    if (!handle || !handle->video_packets) return;
+    flush_video_packets(handle);
+    av_fifo_freep2(&handle->video_packets);
+}
+
+int packet_buffer_is_full(PlayerSession* handle) {
+    if (!handle) return 1;
+    uint32_t buffer_size = get_video_buffer_size(handle);
+    if (handle->has_video && handle->video_packets) {
+        if (handle->video_packets_duration >= (int64_t)buffer_size * 1000 || handle->video_packets_size >= handle->settings->video_buffer_bytes) return 1;
+    }
+    if (handle->has_audio && handle->buffer) {
+        // 提前读取时音频会直接解码，限制其超出音频缓冲区的部分，防止视频包很稀疏时读入整个文件
+        if (av_audio_fifo_size(handle->buffer) >= handle->needed_audio_samples + (int64_t)handle->sdl_spec.freq * buffer_size / 1000) return 1;
+    }
+    return 0;
+}
+
+int read_packet(PlayerSession* handle) {
+    if (!handle) return PLAYER_ERR_NULLPTR;
+    if (handle->demux_is_eof) return AVERROR_EOF;
+    AVPacket pkt;
+    int re = 0;
+    int64_t trace_start = TRACE_BEGIN();
+    re = av_read_frame(handle->fmt, &pkt);
+    TRACE_END("av_read_frame", trace_start, re >= 0 ? trace_ts(pkt.pts, handle->fmt->streams[pkt.stream_index]->time_base) : AV_NOPTS_VALUE);
+    if (re < 0) {
+        if (re == AVERROR_EOF) {
+            // 文件已读完，冲洗音频解码器，视频解码器在数据包缓冲区读完后冲洗
+            handle->demux_is_eof = 1;
+            if (handle->has_audio) avcodec_send_packet(handle->audio_decoder, NULL);
+            seek_index_finish(handle);
+            return PLAYER_ERR_OK;
+        }
+        return re;
+    }
+    seek_index_add_packet(handle, &pkt);
+    if (handle->has_audio && pkt.stream_index == handle->audio_input_stream->index) {
+        // 音频数据很小，直接解码
+        handle->last_pkt_pts = av_rescale_q_rnd(pkt.pts, handle->audio_input_stream->time_base, AV_TIME_BASE_Q, AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
+        while (1) {
+            trace_start = TRACE_BEGIN();
+            re = avcodec_send_packet(handle->audio_decoder, &pkt);
+            TRACE_END("avcodec_send_packet (audio)", trace_start, trace_ts(pkt.pts, handle->audio_input_stream->time_base));
+            if (re != AVERROR(EAGAIN)) break;
+            // 解码器中还有未取出的数据，先取出再发送
+            if ((re = drain_audio_decoder(handle))) break;
+        }
+        av_packet_unref(&pkt);
+        return re < 0 ? re : PLAYER_ERR_OK;
+    } else if (handle->has_video && pkt.stream_index == handle->video_input_stream->index) {
+        handle->last_pkt_pts = av_rescale_q_rnd(pkt.pts, handle->video_input_stream->time_base, AV_TIME_BASE_Q, AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
+        re = put_video_packet(handle, &pkt);
+        av_packet_unref(&pkt);
+        return re;
+    }
+    av_packet_unref(&pkt);
+    return PLAYER_ERR_OK;
+}
+
+/// @brief 从数据包缓冲区取出数据发送给视频解码器，缓冲区为空时从文件读取
+static int send_video_packet(PlayerSession* handle) {
+    int re = 0;
+    while (!av_fifo_can_read(handle->video_packets) && !handle->demux_is_eof) {
+        if ((re = read_packet(handle))) return re;
+    }
+    AVPacket* pkt = get_video_packet(handle);
+    if (!pkt) {
+        if (handle->video_decoder_flushed) {
+            // 已经冲洗过解码器但仍然没有输出，不会再有数据
+            handle->video_is_eof = 1;
+            return PLAYER_ERR_OK;
+        }
+        handle->video_decoder_flushed = 1;
+        re = avcodec_send_packet(handle->video_decoder, NULL);
+        return re < 0 && re != AVERROR_EOF ? re : PLAYER_ERR_OK;
+    }
+    if (handle->applied_video_skip_level != handle->video_skip_level) {
+        apply_video_skip_level(handle);
+    }
+    // 在发送前直接丢弃不需要解码的数据包：可丢弃的帧不被其他帧参考，
+    // 只解码关键帧时丢掉非关键帧后需要等到下一个关键帧才能恢复解码，否则参考帧缺失
+    if (pkt->flags & AV_PKT_FLAG_KEY) {
+        handle->video_skip_until_key = 0;
+    } else if (handle->applied_video_skip_level >= 3) {
+        handle->video_skip_until_key = 1;
+    }
+    if (handle->video_skip_until_key || (handle->applied_video_skip_level >= 2 && (pkt->flags & AV_PKT_FLAG_DISPOSABLE))) {
+        handle->video_skipped_decodes++;
+        av_packet_free(&pkt);
+        return PLAYER_ERR_OK;
+    }
+    int64_t trace_start = TRACE_BEGIN();
+    re = avcodec_send_packet(handle->video_decoder, pkt);
+    TRACE_END("avcodec_send_packet (video)", trace_start, trace_ts(pkt->pts, handle->video_input_stream->time_base));
+    av_packet_free(&pkt);
+    return re < 0 ? re : PLAYER_ERR_OK;
+}
+
 int decode(PlayerSession* handle, char* audio_writed, char* video_writed) {
     if (!handle) return PLAYER_ERR_NULLPTR;
     if (!audio_writed && !video_writed) return PLAYER_ERR_NULLPTR;
-    AVPacket pkt;
     AVFrame* frame = av_frame_alloc();
     if (audio_writed) *audio_writed = 0;
     if (video_writed) *video_writed = 0;
@@ -231,55 +508,21 @@ int decode(PlayerSession* handle, char* audio_writed, char* video_writed) {
         if ((audio_writed && *audio_writed) || (video_writed && *video_writed) || ((!handle->has_audio || handle->audio_is_eof) && (!handle->has_video || handle->video_is_eof))) {
             break;
         }
-        if ((re = av_read_frame(handle->fmt, &pkt)) < 0) {
+        // 解码器需要更多数据，只在解码器取不出数据时才发送，发送不会返回 EAGAIN
+        if (video_writed) {
+            if (!handle->has_video || handle->video_is_eof) break;
+            re = send_video_packet(handle);
+        } else {
+            if (!handle->has_audio || handle->audio_is_eof) break;
+            re = read_packet(handle);
             if (re == AVERROR_EOF) {
+                // 已经冲洗过解码器但仍然没有输出，不会再有数据
                 handle->audio_is_eof = 1;
-                handle->video_is_eof = 1;
                 re = PLAYER_ERR_OK;
-                goto end;
-            }
-            goto end;
-        }
-        if (pkt.stream_index == handle->audio_input_stream->index) {
-            handle->last_pkt_pts = av_rescale_q_rnd(pkt.pts, handle->audio_input_stream->time_base, AV_TIME_BASE_Q, AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
-            if ((re = avcodec_send_packet(handle->audio_decoder, &pkt)) < 0) {
-                if (re == AVERROR(EAGAIN)) {
-                    re = 0;
-                    av_packet_unref(&pkt);
-                    continue;
-                }
-                av_packet_unref(&pkt);
-                goto end;
-            }
-        } else if (pkt.stream_index == handle->video_input_stream->index) {
-            handle->last_pkt_pts = av_rescale_q_rnd(pkt.pts, handle->video_input_stream->time_base, AV_TIME_BASE_Q, AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
-            if ((re = avcodec_send_packet(handle->video_decoder, &pkt)) < 0) {
-                if (re == AVERROR(EAGAIN)) {
-                    re = 0;
-                    av_packet_unref(&pkt);
-                    continue;
-                }
-                av_packet_unref(&pkt);
-                goto end;
+                break;
             }
-        } else {
-            av_packet_unref(&pkt);
-            continue;
-        }
-        av_packet_unref(&pkt);
-        if (handle->has_audio && !handle->audio_is_eof && audio_writed) {
-            if ((re = decode_audio_internal(handle, audio_writed, frame))) {
-                goto end;
-            }
-        }
-        if (handle->has_video && !handle->video_is_eof && video_writed) {
-            if ((re = decode_video_internal(handle, video_writed, frame))) {
-                goto end;
-            }
-        }
-        if ((audio_writed && *audio_writed) || (video_writed && *video_writed) || ((!handle->has_audio || handle->audio_is_eof) && (!handle->has_video || handle->video_is_eof))) {
-            break;
         }
+        if (re) goto end;
     }
 end:
     if (frame) {
@@ -291,3 +534,102 @@ end:
     }
     return re;
 }
+
+void update_video_skip_level(PlayerSession* handle, int dropped) {
+    if (!handle || !handle->settings->frame_skip) return;
+    if (dropped > 0) {
+        handle->skip_ontime_ticks = 0;
+        if (++handle->skip_late_ticks >= VIDEO_SKIP_RAISE_TICKS && handle->video_skip_level < VIDEO_SKIP_MAX_LEVEL) {
+            handle->video_skip_level++;
+            handle->skip_late_ticks = 0;
+            av_log(NULL, AV_LOG_VERBOSE, "Playback is late, raise video skip level to %d.\n", handle->video_skip_level);
+        }
+    } else {
+        handle->skip_late_ticks = 0;
+        if (++handle->skip_ontime_ticks >= VIDEO_SKIP_RECOVER_TICKS && handle->video_skip_level > 0) {
+            handle->video_skip_level--;
+            handle->skip_ontime_ticks = 0;
+            av_log(NULL, AV_LOG_VERBOSE, "Playback caught up, lower video skip level to %d.\n", handle->video_skip_level);
+        }
+    }
+}
+
+void apply_video_skip_level(PlayerSession* handle) {
+    if (!handle || !handle->video_decoder) return;
+    int level = handle->video_skip_level;
+    AVCodecContext* c = handle->video_decoder;
+    // 1: 跳过环路滤波 2: 跳过非参考帧 3: 只解码关键帧
+    c->skip_loop_filter = level >= 1 ? AVDISCARD_ALL : AVDISCARD_DEFAULT;
+    c->skip_idct = level >= 2 ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+    c->skip_frame = level >= 3 ? AVDISCARD_NONKEY : level >= 2 ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+    handle->applied_video_skip_level = level;
+    av_log(NULL, AV_LOG_DEBUG, "Applied video skip level %d.\n", level);
+}
+
+void control_live_latency(PlayerSession* handle, int64_t out_samples) {
+    if (!handle || !handle->has_audio) return;
+    int64_t queued = av_audio_fifo_size(handle->buffer);
+    int64_t target = handle->needed_audio_samples;
+    if (queued > target * LIVE_DROP_FACTOR) {
+        // 延迟过大，直接丢弃多余的样本
+        DWORD res = WaitForSingleObject(handle->mutex, INFINITE);
+        if (res != WAIT_OBJECT_0) return;
+        int drop = av_audio_fifo_size(handle->buffer) - (int)target;
+        if (drop > 0 && av_audio_fifo_drain(handle->buffer, drop) >= 0) {
+            AVRational base = { 1, handle->sdl_spec.freq };
+            handle->pts += av_rescale_q_rnd(drop, base, AV_TIME_BASE_Q, AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
+            handle->live_dropped_samples += drop;
+            av_log(NULL, AV_LOG_VERBOSE, "Live latency too high, dropped %d samples.\n", drop);
+        }
+        ReleaseMutex(handle->mutex);
+    } else if (queued > target) {
+        // 稍微加速播放，逐渐追上延迟
+        int delta = (int)(out_samples * LIVE_SPEEDUP_PERCENT / 100);
+        if (delta > 0 && swr_set_compensation(handle->swrac, -delta, (int)out_samples) >= 0) {
+            handle->live_catching_up = 1;
+        }
+    } else if (handle->live_catching_up) {
+        swr_set_compensation(handle->swrac, 0, 0);
+        handle->live_catching_up = 0;
+    }
+}
+
+int switch_audio_stream(PlayerSession* handle) {
+    if (!handle) return PLAYER_ERR_NULLPTR;
+    // 取出和清除必须是一步，否则两步之间的新请求会丢失
+    int index = (int)InterlockedExchange(&handle->requested_audio_stream, -1);
+    if (index < 0 || (unsigned int)index >= handle->fmt->nb_streams) return PLAYER_ERR_INVALID_STREAM;
+    AVStream* old_stream = handle->audio_input_stream;
+    const AVCodec* old_codec = handle->audio_codec;
+    AVCodecContext* old_decoder = handle->audio_decoder;
+    struct SwrContext* swrac = NULL;
+    int re = PLAYER_ERR_OK;
+    if (handle->fmt->streams[index] == old_stream) return PLAYER_ERR_OK;
+    handle->audio_input_stream = handle->fmt->streams[index];
+    handle->audio_decoder = NULL;
+    if ((re = open_audio_decoder(handle)) || (re = init_audio_resampler(handle, handle->audio_decoder, &swrac))) {
+        goto fail;
+    }
+    free_audio_filter(handle);
+    if ((re = init_audio_filter(handle))) {
+        goto fail;
+    }
+    // 缓冲区中仍有旧音轨的数据，新音轨的数据接在后面，时间轴保持连续
+    swr_free(&handle->swrac);
+    handle->swrac = swrac;
+    avcodec_free_context(&old_decoder);
+    old_stream->discard = AVDISCARD_ALL;
+    handle->audio_input_stream->discard = AVDISCARD_DEFAULT;
+    handle->audio_is_eof = 0;
+    av_log(NULL, AV_LOG_VERBOSE, "Switched audio stream to %d.\n", index);
+    return PLAYER_ERR_OK;
+fail:
+    av_log(NULL, AV_LOG_ERROR, "Failed to switch audio stream to %d.\n", index);
+    if (swrac) swr_free(&swrac);
+    if (handle->audio_decoder) avcodec_free_context(&handle->audio_decoder);
+    handle->audio_input_stream = old_stream;
+    handle->audio_codec = old_codec;
+    handle->audio_decoder = old_decoder;
+    if (!handle->audio_filter_graph) init_audio_filter(handle);
+    return re;
+}
@@ -4,13 +4,54 @@
 extern "C" {
 #endif
 #include "core.h"
+/// 最大跳帧等级
+#define VIDEO_SKIP_MAX_LEVEL 3
+/// 连续多少次刷新发生丢帧后提高跳帧等级
+#define VIDEO_SKIP_RAISE_TICKS 3
+/// 连续多少次刷新未丢帧后降低跳帧等级
+#define VIDEO_SKIP_RECOVER_TICKS 120
+/// 低延迟模式下缓冲超过目标的多少倍时直接丢弃
+#define LIVE_DROP_FACTOR 4
+/// 低延迟模式下追赶延迟时的加速比例（百分比）
+#define LIVE_SPEEDUP_PERCENT 5
 int open_audio_decoder(PlayerSession* session);
 int open_video_decoder(PlayerSession* session);
+/// @brief 解码封面的附加图片，结果保存在 cover_frame 中
+int decode_cover(PlayerSession* session);
 int decode_audio_internal(PlayerSession* handle, char* writed, AVFrame* frame);
 int decode_video_internal(PlayerSession* handle, char* writed, AVFrame* frame);
 int audio_convert_samples_and_add_to_fifo(PlayerSession* handle, AVFrame* frame, char* writed);
 int video_add_to_fifo(PlayerSession* handle, AVFrame* frame, char* writed);
+/**
+ * @brief 从文件读取一个数据包
+ *
+ * 视频数据包放入数据包缓冲区，音频数据包直接发送给解码器。
+ * @return 错误代码，文件已读完后再调用返回 AVERROR_EOF
+*/
+int read_packet(PlayerSession* handle);
+/// @brief 提前读取的数据是否已达到设定的时长或字节数
+int packet_buffer_is_full(PlayerSession* handle);
+/// @brief 清空视频数据包缓冲区
+void flush_video_packets(PlayerSession* handle);
+/// @brief 释放视频数据包缓冲区
+void free_video_packets(PlayerSession* handle);
 int decode(PlayerSession* handle, char* audio_writed, char* video_writed);
+/**
+ * @brief 根据本次刷新是否丢帧调整解码器跳帧等级
+ * @param dropped 本次刷新丢弃的帧数
+*/
+void update_video_skip_level(PlayerSession* handle, int dropped);
+/// @brief 将期望的跳帧等级应用到视频解码器（需在解码线程中调用）
+void apply_video_skip_level(PlayerSession* handle);
+/**
+ * @brief 低延迟模式下控制音频缓冲区的延迟
+ *
+ * 缓冲超过目标时通过重采样稍微加速，超过太多时直接丢弃
+ * @param out_samples 即将转换输出的样本数
+*/
+void control_live_latency(PlayerSession* handle, int64_t out_samples);
+/// @brief 切换到 requested_audio_stream 指定的音频流（需在解码线程中调用）
+int switch_audio_stream(PlayerSession* handle);
 #if __cplusplus
 }
 #endif
@@ -0,0 +1,198 @@
+#include "filter.h"
+#include "decode.h"
+#include "libavutil/bprint.h"
+
+static int create_filter_graph(AVFilterGraph** graph, AVFilterContext** src, AVFilterContext** sink, const char* src_name, const char* src_args, const char* sink_name, const char* desc) {
+    int re = 0;
+    AVFilterInOut* outputs = avfilter_inout_alloc();
+    AVFilterInOut* inputs = avfilter_inout_alloc();
+    if (!(*graph = avfilter_graph_alloc()) || !outputs || !inputs) {
+        re = PLAYER_ERR_OOM;
+        goto end;
+    }
+    if ((re = avfilter_graph_create_filter(src, avfilter_get_by_name(src_name), "in", src_args, NULL, *graph)) < 0) {
+        av_log(NULL, AV_LOG_FATAL, "Failed to create %s filter: %s (%i)\n", src_name, av_err2str(re), re);
+        goto end;
+    }
+    if ((re = avfilter_graph_create_filter(sink, avfilter_get_by_name(sink_name), "out", NULL, NULL, *graph)) < 0) {
+        av_log(NULL, AV_LOG_FATAL, "Failed to create %s filter: %s (%i)\n", sink_name, av_err2str(re), re);
+        goto end;
+    }
+    outputs->name = av_strdup("in");
+    outputs->filter_ctx = *src;
+    outputs->pad_idx = 0;
+    outputs->next = NULL;
+    inputs->name = av_strdup("out");
+    inputs->filter_ctx = *sink;
+    inputs->pad_idx = 0;
+    inputs->next = NULL;
+    if (!outputs->name || !inputs->name) {
+        re = PLAYER_ERR_OOM;
+        goto end;
+    }
+    if ((re = avfilter_graph_parse_ptr(*graph, desc, &inputs, &outputs, NULL)) < 0) {
+        av_log(NULL, AV_LOG_FATAL, "Failed to parse filter \"%s\": %s (%i)\n", desc, av_err2str(re), re);
+        goto end;
+    }
+    if ((re = avfilter_graph_config(*graph, NULL)) < 0) {
+        av_log(NULL, AV_LOG_FATAL, "Failed to configure filter \"%s\": %s (%i)\n", desc, av_err2str(re), re);
+        goto end;
+    }
+    av_log(NULL, AV_LOG_VERBOSE, "Filter graph configured: %s\n", desc);
+    re = PLAYER_ERR_OK;
+end:
+    avfilter_inout_free(&outputs);
+    avfilter_inout_free(&inputs);
+    if (re) avfilter_graph_free(graph);
+    return re;
+}
+
+int init_audio_filter(PlayerSession* session) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    if (!session->has_audio) return PLAYER_ERR_OK;
+    if (!session->audio_decoder) return PLAYER_ERR_NULLPTR;
+    double speed = session->settings->speed;
+    if (!session->settings->audio_filter && speed == 1.0) return PLAYER_ERR_OK;
+    AVCodecContext* dec = session->audio_decoder;
+    char layout[128];
+    char args[512];
+    AVBPrint desc;
+    int re = 0;
+    if ((re = av_channel_layout_describe(&dec->ch_layout, layout, sizeof(layout))) < 0) {
+        return re;
+    }
+    snprintf(args, sizeof(args), "time_base=%d/%d:sample_rate=%d:sample_fmt=%s:channel_layout=%s", session->audio_input_stream->time_base.num, session->audio_input_stream->time_base.den, dec->sample_rate, av_get_sample_fmt_name(dec->sample_fmt), layout);
+    av_bprint_init(&desc, 0, AV_BPRINT_SIZE_UNLIMITED);
+    av_bprintf(&desc, "%s,", session->settings->audio_filter ? session->settings->audio_filter : "anull");
+    if (speed != 1.0) {
+        // 旧版本的 atempo 只支持 0.5 - 2.0
+        while (speed > 2.0) {
+            av_bprintf(&desc, "atempo=2.0,");
+            speed /= 2.0;
+        }
+        av_bprintf(&desc, "atempo=%f,", speed);
+    }
+    // 保证输出格式与解码器一致，后续的重采样和缓冲区都基于解码器的格式
+    av_bprintf(&desc, "aformat=sample_fmts=%s:sample_rates=%d:channel_layouts=%s", av_get_sample_fmt_name(dec->sample_fmt), dec->sample_rate, layout);
+    if (!av_bprint_is_complete(&desc)) {
+        av_bprint_finalize(&desc, NULL);
+        return PLAYER_ERR_OOM;
+    }
+    re = create_filter_graph(&session->audio_filter_graph, &session->audio_filter_src, &session->audio_filter_sink, "abuffer", args, "abuffersink", desc.str);
+    av_bprint_finalize(&desc, NULL);
+    return re;
+}
+
+int init_video_filter(PlayerSession* session) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    if (!session->has_video) return PLAYER_ERR_OK;
+    if (!session->video_decoder) return PLAYER_ERR_NULLPTR;
+    AVCodecContext* dec = session->video_decoder;
+    session->video_frame_rate = dec->framerate;
+    if (!session->settings->video_filter) return PLAYER_ERR_OK;
+    char args[512];
+    AVRational sar = dec->sample_aspect_ratio.num ? dec->sample_aspect_ratio : av_make_q(1, 1);
+    AVRational tb = session->video_input_stream->time_base;
+    int re = 0;
+    snprintf(args, sizeof(args), "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d", dec->width, dec->height, dec->pix_fmt, tb.num, tb.den, sar.num, sar.den);
+    if (dec->framerate.num && dec->framerate.den) {
+        size_t len = strlen(args);
+        snprintf(args + len, sizeof(args) - len, ":frame_rate=%d/%d", dec->framerate.num, dec->framerate.den);
+    }
+    if ((re = create_filter_graph(&session->video_filter_graph, &session->video_filter_src, &session->video_filter_sink, "buffer", args, "buffersink", session->settings->video_filter))) {
+        return re;
+    }
+    // 滤镜可能改变帧率（如 yadif=1、fps）
+    AVRational rate = av_buffersink_get_frame_rate(session->video_filter_sink);
+    if (rate.num && rate.den) session->video_frame_rate = rate;
+    return PLAYER_ERR_OK;
+}
+
+void free_audio_filter(PlayerSession* session) {
+    if (!session) return;
+    if (session->audio_filter_graph) avfilter_graph_free(&session->audio_filter_graph);
+    session->audio_filter_src = NULL;
+    session->audio_filter_sink = NULL;
+    session->audio_filter_flushed = 0;
+}
+
+void free_video_filter(PlayerSession* session) {
+    if (!session) return;
+    if (session->video_filter_graph) avfilter_graph_free(&session->video_filter_graph);
+    session->video_filter_src = NULL;
+    session->video_filter_sink = NULL;
+    session->video_filter_flushed = 0;
+}
+
+void free_filters(PlayerSession* session) {
+    free_audio_filter(session);
+    free_video_filter(session);
+}
+
+int push_audio_filter(PlayerSession* handle, AVFrame* frame) {
+    if (!handle || !handle->audio_filter_graph) return PLAYER_ERR_NULLPTR;
+    int re = 0;
+    if (!frame) {
+        if (handle->audio_filter_flushed) return PLAYER_ERR_OK;
+        handle->audio_filter_flushed = 1;
+    }
+    if ((re = av_buffersrc_add_frame(handle->audio_filter_src, frame)) < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to send audio frame to filter: %s (%i)\n", av_err2str(re), re);
+        return re;
+    }
+    return PLAYER_ERR_OK;
+}
+
+int push_video_filter(PlayerSession* handle, AVFrame* frame) {
+    if (!handle || !handle->video_filter_graph) return PLAYER_ERR_NULLPTR;
+    int re = 0;
+    if (!frame) {
+        if (handle->video_filter_flushed) return PLAYER_ERR_OK;
+        handle->video_filter_flushed = 1;
+    }
+    if ((re = av_buffersrc_add_frame(handle->video_filter_src, frame)) < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to send video frame to filter: %s (%i)\n", av_err2str(re), re);
+        return re;
+    }
+    return PLAYER_ERR_OK;
+}
+
+int pull_audio_filter(PlayerSession* handle, AVFrame* frame, char* writed) {
+    if (!handle || !frame || !writed) return PLAYER_ERR_NULLPTR;
+    av_frame_unref(frame);
+    int re = av_buffersink_get_frame(handle->audio_filter_sink, frame);
+    if (re >= 0) {
+        re = audio_convert_samples_and_add_to_fifo(handle, frame, writed);
+        av_frame_unref(frame);
+        return re;
+    } else if (re == AVERROR(EAGAIN)) {
+        return PLAYER_ERR_OK;
+    } else if (re == AVERROR_EOF) {
+        handle->audio_is_eof = 1;
+        return PLAYER_ERR_OK;
+    }
+    return re;
+}
+
+int pull_video_filter(PlayerSession* handle, AVFrame* frame, char* writed) {
+    if (!handle || !frame || !writed) return PLAYER_ERR_NULLPTR;
+    av_frame_unref(frame);
+    int re = av_buffersink_get_frame(handle->video_filter_sink, frame);
+    if (re >= 0) {
+        // 滤镜（如 fps、settb）可能改变时间基，统一换算到流的时间基，后续按流的时间基计算帧时间
+        AVRational tb = av_buffersink_get_time_base(handle->video_filter_sink), stb = handle->video_input_stream->time_base;
+        if (av_cmp_q(tb, stb)) {
+            frame->pts = av_rescale_q_rnd(frame->pts, tb, stb, AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
+            if (frame->duration > 0) frame->duration = av_rescale_q(frame->duration, tb, stb);
+        }
+        // 滤镜复制或生成的帧保留着输入帧的 best_effort_timestamp，以滤镜输出的 pts 为准
+        frame->best_effort_timestamp = frame->pts;
+        return video_add_to_fifo(handle, frame, writed);
+    } else if (re == AVERROR(EAGAIN)) {
+        return PLAYER_ERR_OK;
+    } else if (re == AVERROR_EOF) {
+        handle->video_is_eof = 1;
+        return PLAYER_ERR_OK;
+    }
+    return re;
+}
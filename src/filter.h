@@ -0,0 +1,32 @@
+#ifndef _PLAYER_FILTER_H
+#define _PLAYER_FILTER_H
+#if __cplusplus
+extern "C" {
+#endif
+#include "core.h"
+/// 播放速度下限
+#define PLAYER_MIN_SPEED 0.5
+/// 播放速度上限
+#define PLAYER_MAX_SPEED 4.0
+int init_audio_filter(PlayerSession* session);
+int init_video_filter(PlayerSession* session);
+void free_audio_filter(PlayerSession* session);
+void free_video_filter(PlayerSession* session);
+void free_filters(PlayerSession* session);
+/**
+ * @brief 将解码后的音频帧送入滤镜
+ * @param frame 音频帧，为NULL时表示解码器已无更多数据
+*/
+int push_audio_filter(PlayerSession* handle, AVFrame* frame);
+int push_video_filter(PlayerSession* handle, AVFrame* frame);
+/**
+ * @brief 从滤镜中取出一帧音频并添加到缓冲区
+ *
+ * 滤镜暂无输出时返回 PLAYER_ERR_OK 且不设置 writed
+*/
+int pull_audio_filter(PlayerSession* handle, AVFrame* frame, char* writed);
+int pull_video_filter(PlayerSession* handle, AVFrame* frame, char* writed);
+#if __cplusplus
+}
+#endif
+#endif
@@ -1,17 +1,164 @@
 #include "loop.h"
 #include "decode.h"
 #include "video_output.h"
+#include "playlist.h"
+#include "audio_output.h"
+#include "thread_priority.h"
+#include "trace.h"
+#include "adaptive_buffer.h"
+
+void wake_decode_loop(PlayerSession* session) {
+    if (session && session->decode_event) SetEvent(session->decode_event);
+}
+
+void wake_event_loop(PlayerSession* session) {
+    if (session && session->event_wakeup) SetEvent(session->event_wakeup);
+}
+
+/// @brief 等待解码线程被唤醒
+static void wait_decode_event(PlayerSession* h, HANDLE preload_thread) {
+    HANDLE handles[2] = { h->decode_event, preload_thread };
+    WaitForMultipleObjects(preload_thread ? 2 : 1, handles, FALSE, INFINITE);
+    h->decode_wakeups++;
+}
+
+/// @brief 事件关联的窗口，不属于任何窗口时返回 0
+static Uint32 event_window_id(const SDL_Event* e) {
+    switch (e->type) {
+    case SDL_WINDOWEVENT:
+        return e->window.windowID;
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        return e->key.windowID;
+    case SDL_TEXTEDITING:
+        return e->edit.windowID;
+    case SDL_TEXTINPUT:
+        return e->text.windowID;
+    case SDL_MOUSEMOTION:
+        return e->motion.windowID;
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        return e->button.windowID;
+    case SDL_MOUSEWHEEL:
+        return e->wheel.windowID;
+    case SDL_DROPFILE:
+    case SDL_DROPTEXT:
+    case SDL_DROPBEGIN:
+    case SDL_DROPCOMPLETE:
+        return e->drop.windowID;
+    default:
+        return 0;
+    }
+}
+
+typedef struct SessionEventFilter {
+    PlayerSession* h;
+    Uint32 window_id;
+    SDL_Event* e;
+    int found;
+} SessionEventFilter;
+
+static int SDLCALL session_event_filter(void* userdata, SDL_Event* e) {
+    SessionEventFilter* f = (SessionEventFilter*)userdata;
+    if (f->found) return 1;
+    if (e->type >= SDL_USEREVENT) {
+        // 自定义事件只交给 data1 指向的会话
+        if (e->user.data1 != f->h) return 1;
+    } else {
+        // 不属于任何窗口的事件（如 SDL_QUIT）没有会话处理，由取到的线程丢弃
+        Uint32 id = event_window_id(e);
+        if (id && id != f->window_id) return 1;
+    }
+    *f->e = *e;
+    f->found = 1;
+    return 0;
+}
+
+static int SDLCALL drop_session_event_filter(void* userdata, SDL_Event* e) {
+    return e->type < SDL_USEREVENT || e->user.data1 != userdata;
+}
+
+void drop_session_events(PlayerSession* session) {
+    // 会话释放后地址可能被新的会话重用，残留的退出事件会让新会话直接退出
+    if (session) SDL_FilterEvents(drop_session_event_filter, session);
+}
+
+/**
+ * @brief 从共享的事件队列中取出一个属于本会话的事件，其他窗口和会话的事件留在队列中
+ * @return 1 取到了事件
+*/
+static int poll_session_event(PlayerSession* h, SDL_Event* e) {
+    SessionEventFilter f;
+    f.h = h;
+    f.window_id = h->window ? SDL_GetWindowID(h->window) : 0;
+    f.e = e;
+    f.found = 0;
+    // 只处理本线程的窗口消息，其他窗口的消息由创建它的线程处理
+    SDL_PumpEvents();
+    SDL_FilterEvents(session_event_filter, &f);
+    return f.found;
+}
+
+/**
+ * @brief 等待 SDL 事件，直到本线程的窗口有消息或会话被唤醒，期间处理刷新请求
+ *
+ * 不使用 SDL_WaitEventTimeout：多个线程同时等待时它会退化为每毫秒轮询一次。
+ * @return 1 取到了事件，0 会话正在退出
+*/
+static int wait_session_event(PlayerSession* h, SDL_Event* e) {
+    while (1) {
+        // 刷新画面在创建渲染器的事件线程中进行
+        if (InterlockedExchange(&h->refresh_requested, 0)) {
+            if (h->has_cover) cover_refresh(h);
+            else video_refresh_timer(h);
+        }
+        if (poll_session_event(h, e)) return 1;
+        if (h->stoping) return 0;
+        MsgWaitForMultipleObjectsEx(1, &h->event_wakeup, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+        h->event_wakeups++;
+    }
+}
 
 DWORD WINAPI decode_loop(LPVOID handle) {
     if (!handle) return PLAYER_ERR_NULLPTR;
     PlayerSession* h = (PlayerSession*)handle;
     char doing = 0;
     char audio_writed = 0, video_writed = 0;
+    apply_thread_settings(h, PLAYER_THREAD_DECODE);
+    trace_set_thread_name("decode");
     av_log(NULL, AV_LOG_VERBOSE, "Needed audio samples: %lld\n", h->needed_audio_samples);
     av_log(NULL, AV_LOG_VERBOSE, "Needed video frames: %lld\n", h->needed_video_frames);
+    av_log(NULL, AV_LOG_VERBOSE, "Video packet buffer: %u ms, %u bytes\n", get_video_buffer_size(h), h->settings->video_buffer_bytes);
     while (1) {
         doing = 0;
         if (h->stoping) break;
+        if (h->decode_pause_requested) {
+            // 其他线程正在替换文件，不访问任何解码相关的数据
+            h->decode_parked = 1;
+            SetEvent(h->decode_parked_event);
+            wait_decode_event(h, NULL);
+            continue;
+        }
+        h->decode_parked = 0;
+        update_adaptive_buffer(h);
+        if (h->requested_audio_stream >= 0) {
+            int re = switch_audio_stream(h);
+            if (re) {
+                av_log(NULL, AV_LOG_WARNING, "%s %i: Error when calling switch_audio_stream: %s (%i).\n", __FILE__, __LINE__, av_err2str(re), re);
+            }
+        }
+        if (h->next && (!h->has_audio || h->audio_is_eof) && (!h->has_video || h->video_is_eof)) {
+            // 当前文件已解码完毕，切换到预加载的下一个文件
+            if (next_item_is_ready(h)) {
+                int re = switch_to_next_item(h);
+                if (re) {
+                    av_log(NULL, AV_LOG_WARNING, "%s %i: Error when calling switch_to_next_item: %s (%i).\n", __FILE__, __LINE__, av_err2str(re), re);
+                    h->have_err = 1;
+                    h->err = re;
+                }
+                doing = 1;
+            }
+        }
         if (h->has_audio && !h->audio_is_eof) {
             if (av_audio_fifo_size(h->buffer) < h->needed_audio_samples) {
                 int re = decode(handle, &audio_writed, NULL);
@@ -22,13 +169,18 @@ DWORD WINAPI decode_loop(LPVOID handle) {
                 }
                 doing = 1;
             }
-        } else if (h->has_audio && h->audio_is_eof) {
+        } else if (h->has_audio && h->audio_is_eof && !h->next) {
             if (av_audio_fifo_size(h->buffer) == 0) {
-                SDL_PauseAudioDevice(h->device_id, 1);
+                set_audio_output_paused(h, 1);
                 h->is_playing = 0;
             }
         } 
-        if (h->has_video && av_fifo_can_write(h->video_buffer)) {
+        if (!h->has_audio && h->has_video && h->video_is_eof && !h->next) {
+            if (av_fifo_can_read(h->video_buffer) == 0) {
+                h->is_playing = 0;
+            }
+        }
+        if (h->has_video && !h->video_is_eof && av_fifo_can_write(h->video_buffer)) {
             int re = decode(handle, NULL, &video_writed);
             if (re) {
                 av_log(NULL, AV_LOG_WARNING, "%s %i: Error when calling decode_video: %s (%i).\n", __FILE__, __LINE__, av_err2str(re), re);
@@ -37,47 +189,92 @@ DWORD WINAPI decode_loop(LPVOID handle) {
             }
             doing = 1;
         }
+        if (h->has_video && !h->demux_is_eof && !packet_buffer_is_full(h)) {
+            // 提前读取数据包，读取卡顿时仍有足够的数据可以解码
+            int re = read_packet(h);
+            if (re) {
+                av_log(NULL, AV_LOG_WARNING, "%s %i: Error when calling read_packet: %s (%i).\n", __FILE__, __LINE__, av_err2str(re), re);
+                h->have_err = 1;
+                h->err = re;
+            }
+            doing = 1;
+        }
         if (!doing) {
-            Sleep(1);
+            // 缓冲区已满或已暂停，等待缓冲区有空间或其他请求；当前文件已解码完毕时还要等待预加载完成
+            char item_finished = (!h->has_audio || h->audio_is_eof) && (!h->has_video || h->video_is_eof);
+            wait_decode_event(h, item_finished && h->next ? h->preload_thread : NULL);
         }
     }
+    revert_thread_settings(h, PLAYER_THREAD_DECODE);
     return 0;
 }
 
 DWORD WINAPI event_loop(LPVOID handle) {
     if (!handle) return PLAYER_ERR_NULLPTR;
     PlayerSession* h = (PlayerSession*)handle;
+    apply_thread_settings(h, PLAYER_THREAD_EVENT);
+    trace_set_thread_name("event");
     if (!h->video_is_init) h->err = init_video_output(h);
+    Uint32 window_id = h->window ? SDL_GetWindowID(h->window) : 0;
     SDL_Event e;
-    while (1) {
-        if (SDL_WaitEventTimeout(&e, 1)) {
-            av_log(NULL, AV_LOG_DEBUG, "Event type: %d\n", e.type);
-            switch (e.type) {
-            case SDL_WINDOWEVENT:
-                av_log(NULL, AV_LOG_DEBUG, "Window event: %d\n", e.window.event);
-                if (e.window.event == SDL_WINDOWEVENT_CLOSE) {
-                    h->is_playing = 0;
-                    if (h->has_audio && h->device_id) {
-                        SDL_PauseAudioDevice(h->device_id, 1);
-                    }
-                    h->stoping = 1;
-                    return 0;
-                }
-                break;  
-            case FF_QUIT_EVENT:
-                return 0;
-            case FF_REFRESH_EVENT:
-                video_refresh_timer(e.user.data1);
-                break;
-            default:
-                break;
+    while (wait_session_event(h, &e)) {
+        av_log(NULL, AV_LOG_DEBUG, "Event type: %d\n", e.type);
+        switch (e.type) {
+        case SDL_WINDOWEVENT:
+            if (e.window.windowID != window_id) break;
+            av_log(NULL, AV_LOG_DEBUG, "Window event: %d\n", e.window.event);
+            if (e.window.event == SDL_WINDOWEVENT_CLOSE) {
+                h->is_playing = 0;
+                set_audio_output_paused(h, 1);
+                h->stoping = 1;
+                goto end;
             }
-        } else {
-            if (h->stoping) {
-                return 0;
+            break;  
+        case FF_QUIT_EVENT:
+            goto end;
+        case FF_REFRESH_EVENT:
+            video_refresh_timer(h);
+            break;
+        default:
+            break;
+        }
+    }
+end:
+    revert_thread_settings(h, PLAYER_THREAD_EVENT);
+    return 0;
+}
+
+DWORD WINAPI cover_event_loop(LPVOID handle) {
+    if (!handle) return PLAYER_ERR_NULLPTR;
+    PlayerSession* h = (PlayerSession*)handle;
+    SDL_Event e;
+    apply_thread_settings(h, PLAYER_THREAD_EVENT);
+    trace_set_thread_name("event");
+    if (!h->video_is_init && (h->err = init_cover_output(h))) goto end;
+    cover_display(h);
+    Uint32 window_id = SDL_GetWindowID(h->window);
+    // 没有定时刷新，只在窗口事件时唤醒
+    while (wait_session_event(h, &e)) {
+        switch (e.type) {
+        case SDL_WINDOWEVENT:
+            if (e.window.windowID != window_id) break;
+            if (e.window.event == SDL_WINDOWEVENT_EXPOSED || e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                cover_display(h);
+            } else if (e.window.event == SDL_WINDOWEVENT_CLOSE && !h->is_external_window) {
+                h->is_playing = 0;
+                set_audio_output_paused(h, 1);
+                h->stoping = 1;
+                goto end;
             }
+            break;
+        case FF_QUIT_EVENT:
+            goto end;
+        default:
+            break;
         }
     }
+end:
+    revert_thread_settings(h, PLAYER_THREAD_EVENT);
     return 0;
 }
 
@@ -85,21 +282,20 @@ DWORD WINAPI external_window_event_loop(LPVOID handle) {
     if (!handle) return PLAYER_ERR_NULLPTR;
     PlayerSession* h = (PlayerSession*)handle;
     SDL_Event e;
-    while (1) {
-        if (SDL_WaitEventTimeout(&e, 1)) {
-            switch (e.type) {
-            case FF_QUIT_EVENT:
-                return 0;
-            case FF_REFRESH_EVENT:
-                video_refresh_timer(e.user.data1);
-                break;
-            default:
-                break;
-            }
-        } else {
-            if (h->stoping) {
-                return 0;
-            }
+    apply_thread_settings(h, PLAYER_THREAD_EVENT);
+    trace_set_thread_name("event");
+    while (wait_session_event(h, &e)) {
+        switch (e.type) {
+        case FF_QUIT_EVENT:
+            goto end;
+        case FF_REFRESH_EVENT:
+            video_refresh_timer(h);
+            break;
+        default:
+            break;
         }
     }
+end:
+    revert_thread_settings(h, PLAYER_THREAD_EVENT);
+    return 0;
 }
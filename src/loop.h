@@ -7,6 +7,18 @@ extern "C" {
 DWORD WINAPI decode_loop(LPVOID handle);
 DWORD WINAPI event_loop(LPVOID handle);
 DWORD WINAPI external_window_event_loop(LPVOID handle);
+/// @brief 只显示封面时的事件处理，窗口需要重绘时才绘制
+DWORD WINAPI cover_event_loop(LPVOID handle);
+/**
+ * @brief 唤醒解码线程
+ *
+ * 解码线程无事可做时一直等待，缓冲区有空间、请求切换或退出时需要调用
+*/
+void wake_decode_loop(PlayerSession* session);
+/// @brief 唤醒事件线程，用于通知退出
+void wake_event_loop(PlayerSession* session);
+/// @brief 丢弃事件队列中发给该会话且未被取走的自定义事件，事件线程结束后调用
+void drop_session_events(PlayerSession* session);
 #if __cplusplus
 }
 #endif
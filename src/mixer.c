@@ -0,0 +1,242 @@
+#include "mixer.h"
+#include "audio_output.h"
+#include "trace.h"
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define MIXER_USE_SSE 1
+#else
+#define MIXER_USE_SSE 0
+#endif
+
+typedef struct Mixer {
+    SDL_AudioDeviceID device_id;
+    /// @brief 设备实际使用的格式
+    SDL_AudioSpec spec;
+    PlayerSession* sessions[MIXER_MAX_SESSIONS];
+    int count;
+    /// @brief 读取单个会话数据的临时缓冲区
+    float* scratch;
+    /// @brief 临时缓冲区的大小（单位：float）
+    int scratch_size;
+} Mixer;
+
+static Mixer mixer;
+/// 保护混音器的打开、关闭和会话的加入、移除，回调中使用 SDL_LockAudioDevice 同步
+static SRWLOCK mixer_lock = SRWLOCK_INIT;
+static volatile LONG64 mixer_callbacks = 0;
+static volatile LONG64 mixer_total_time = 0;
+static volatile LONG64 mixer_last_time = 0;
+
+/// @brief out += in * gain
+static void mix_constant(float* out, const float* in, int count, float gain) {
+    if (gain == 0.0f) return;
+    int i = 0;
+#if MIXER_USE_SSE
+    __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), g)));
+    }
+#endif
+    for (; i < count; i++) out[i] += in[i] * gain;
+}
+
+/// @brief out += in * gain，gain 在 frames 帧内从 from 线性变化到 to，避免音量突变产生爆音
+static void mix_ramp(float* out, const float* in, int frames, int channels, float from, float to) {
+    if (from == to) {
+        mix_constant(out, in, frames * channels, to);
+        return;
+    }
+    float step = (to - from) / frames;
+    float gain = from;
+    int i = 0;
+#if MIXER_USE_SSE
+    if (channels == 1 || channels == 2) {
+        // 一次处理 4 个样本，即 4 帧单声道或 2 帧立体声，每帧的增益依次增加 step
+        int per = 4 / channels;
+        __m128 g = channels == 1 ? _mm_setr_ps(from + step, from + 2 * step, from + 3 * step, from + 4 * step)
+                                 : _mm_setr_ps(from + step, from + step, from + 2 * step, from + 2 * step);
+        __m128 inc = _mm_set1_ps(step * per);
+        for (; i + per <= frames; i += per) {
+            float* o = out + i * channels;
+            _mm_storeu_ps(o, _mm_add_ps(_mm_loadu_ps(o), _mm_mul_ps(_mm_loadu_ps(in + i * channels), g)));
+            g = _mm_add_ps(g, inc);
+        }
+        gain = from + step * i;
+    }
+#endif
+    for (; i < frames; i++) {
+        gain += step;
+        for (int c = 0; c < channels; c++) {
+            out[i * channels + c] += in[i * channels + c] * gain;
+        }
+    }
+}
+
+/// @brief 限制到 [-1, 1]
+static void clip(float* out, int count) {
+    int i = 0;
+#if MIXER_USE_SSE
+    __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(out + i), lo), hi));
+    }
+#endif
+    for (; i < count; i++) out[i] = out[i] < -1.0f ? -1.0f : out[i] > 1.0f ? 1.0f : out[i];
+}
+
+/**
+ * @brief 从 offset 开始把会话的数据混入 out，不等待会话的锁
+ * @param offset 开始的位置（单位：float），返回时为混到的位置
+ * @return 0 混音完成，-1 解码线程正在写入，offset 之后的部分还没有混音
+*/
+static int mix_session(PlayerSession* s, float* out, int count, int* offset, float target) {
+    int channels = mixer.spec.channels;
+    int64_t session_start = av_gettime_relative();
+    int re = 0;
+    // 静音的会话同样要取出数据，保持音频时钟继续前进
+    for (; *offset < count; *offset += mixer.scratch_size) {
+        int n = FFMIN(mixer.scratch_size, count - *offset);
+        int frames = n / channels;
+        int64_t trace_start = TRACE_BEGIN();
+        re = read_audio_buffer(s, (uint8_t*)mixer.scratch, frames * channels * sizeof(float), 0);
+        TRACE_END("mixer read", trace_start, s->pts);
+        if (re < 0) break;
+        mix_ramp(out + *offset, mixer.scratch, frames, channels, s->mixer_applied_gain, target);
+        s->mixer_applied_gain = target;
+    }
+    s->mixer_time += av_gettime_relative() - session_start;
+    return re < 0 ? -1 : 0;
+}
+
+static void mixer_callback(void* userdata, uint8_t* stream, int len) {
+    int64_t start = av_gettime_relative();
+    float* out = (float*)stream;
+    int count = len / (int)sizeof(float);
+    memset(stream, 0, len);
+    int solo = 0;
+    for (int i = 0; i < mixer.count; i++) {
+        if (mixer.sessions[i]->mixer_playing && mixer.sessions[i]->mixer_solo) solo = 1;
+    }
+    // 回调不能等待任何一个会话的锁，否则一个会话就会让所有会话断音
+    int deferred[MIXER_MAX_SESSIONS];
+    int deferred_offset[MIXER_MAX_SESSIONS];
+    int deferred_count = 0;
+    for (int i = 0; i < mixer.count; i++) {
+        PlayerSession* s = mixer.sessions[i];
+        if (!s->mixer_playing) continue;
+        float target = s->mixer_mute || (solo && !s->mixer_solo) ? 0.0f : s->mixer_gain;
+        int offset = 0;
+        if (mix_session(s, out, count, &offset, target)) {
+            deferred[deferred_count] = i;
+            deferred_offset[deferred_count] = offset;
+            deferred_count++;
+        }
+        s->mixer_calls++;
+    }
+    // 解码线程写入缓冲区只需很短的时间，混完其他会话后再试一次，仍然争用时这部分输出空白，数据留到下次播放
+    for (int i = 0; i < deferred_count; i++) {
+        PlayerSession* s = mixer.sessions[deferred[i]];
+        float target = s->mixer_mute || (solo && !s->mixer_solo) ? 0.0f : s->mixer_gain;
+        mix_session(s, out, count, &deferred_offset[i], target);
+    }
+    clip(out, count);
+    TRACE_END("mixer callback", trace_enabled ? start : 0, AV_NOPTS_VALUE);
+    int64_t elapsed = av_gettime_relative() - start;
+    InterlockedIncrement64(&mixer_callbacks);
+    InterlockedExchangeAdd64(&mixer_total_time, elapsed);
+    InterlockedExchange64(&mixer_last_time, elapsed);
+}
+
+/// @brief 打开音频设备，需要持有 mixer_lock
+static int open_mixer(PlayerSettings* settings) {
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO)) {
+        av_log(NULL, AV_LOG_FATAL, "Failed to initialize SDL audio: %s\n", SDL_GetError());
+        return PLAYER_ERR_SDL;
+    }
+    SDL_AudioSpec spec;
+    memset(&spec, 0, sizeof(SDL_AudioSpec));
+    spec.freq = MIXER_SAMPLE_RATE;
+    spec.format = AUDIO_F32SYS;
+    spec.channels = MIXER_CHANNELS;
+    spec.samples = settings->audio_period ? settings->audio_period : MIXER_SAMPLE_RATE / 100;
+    spec.callback = mixer_callback;
+    // 不允许改变格式，由 SDL 转换到设备的格式
+    mixer.device_id = SDL_OpenAudioDevice(settings->audio_device, 0, &spec, &mixer.spec, 0);
+    if (!mixer.device_id) {
+        av_log(NULL, AV_LOG_FATAL, "Failed to open audio device: %s\n", SDL_GetError());
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return PLAYER_ERR_SDL;
+    }
+    mixer.scratch_size = mixer.spec.samples * mixer.spec.channels;
+    if (!(mixer.scratch = (float*)av_malloc_array(mixer.scratch_size, sizeof(float)))) {
+        SDL_CloseAudioDevice(mixer.device_id);
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        memset(&mixer, 0, sizeof(Mixer));
+        return PLAYER_ERR_OOM;
+    }
+    av_log(NULL, AV_LOG_VERBOSE, "Mixer opened: %dHz, %d channels, %d samples per period.\n", mixer.spec.freq, mixer.spec.channels, mixer.spec.samples);
+    // 设备一直运行，没有会话播放时输出空白数据
+    SDL_PauseAudioDevice(mixer.device_id, 0);
+    return PLAYER_ERR_OK;
+}
+
+int mixer_add_session(PlayerSession* session) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    int re = PLAYER_ERR_OK;
+    AcquireSRWLockExclusive(&mixer_lock);
+    if (mixer.count >= MIXER_MAX_SESSIONS) {
+        av_log(NULL, AV_LOG_ERROR, "Too many sessions in mixer.\n");
+        re = PLAYER_ERR_TOO_MANY_SESSIONS;
+        goto end;
+    }
+    if (!mixer.device_id && (re = open_mixer(session->settings))) {
+        goto end;
+    }
+    memcpy(&session->sdl_spec, &mixer.spec, sizeof(SDL_AudioSpec));
+    session->mixer_playing = 0;
+    session->use_mixer = 1;
+    SDL_LockAudioDevice(mixer.device_id);
+    mixer.sessions[mixer.count++] = session;
+    SDL_UnlockAudioDevice(mixer.device_id);
+end:
+    ReleaseSRWLockExclusive(&mixer_lock);
+    return re;
+}
+
+void mixer_remove_session(PlayerSession* session) {
+    if (!session || !session->use_mixer) return;
+    AcquireSRWLockExclusive(&mixer_lock);
+    // 回调结束后才会移除，之后不会再访问该会话
+    SDL_LockAudioDevice(mixer.device_id);
+    for (int i = 0; i < mixer.count; i++) {
+        if (mixer.sessions[i] == session) {
+            mixer.sessions[i] = mixer.sessions[--mixer.count];
+            mixer.sessions[mixer.count] = NULL;
+            break;
+        }
+    }
+    SDL_UnlockAudioDevice(mixer.device_id);
+    session->use_mixer = 0;
+    session->mixer_playing = 0;
+    if (!mixer.count) {
+        SDL_CloseAudioDevice(mixer.device_id);
+        av_free(mixer.scratch);
+        memset(&mixer, 0, sizeof(Mixer));
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        av_log(NULL, AV_LOG_VERBOSE, "Mixer closed.\n");
+    }
+    ReleaseSRWLockExclusive(&mixer_lock);
+}
+
+void mixer_get_stats(PlayerMixerStats* stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(PlayerMixerStats));
+    AcquireSRWLockShared(&mixer_lock);
+    stats->sessions = mixer.count;
+    stats->sample_rate = mixer.spec.freq;
+    stats->channels = mixer.spec.channels;
+    ReleaseSRWLockShared(&mixer_lock);
+    stats->callbacks = (uint64_t)InterlockedCompareExchange64(&mixer_callbacks, 0, 0);
+    stats->total_time = InterlockedCompareExchange64(&mixer_total_time, 0, 0);
+    stats->last_time = InterlockedCompareExchange64(&mixer_last_time, 0, 0);
+}
@@ -0,0 +1,24 @@
+#ifndef _PLAYER_MIXER_H
+#define _PLAYER_MIXER_H
+#if __cplusplus
+extern "C" {
+#endif
+#include "core.h"
+/// 混音器最多同时输出的会话数
+#define MIXER_MAX_SESSIONS 64
+/// 混音器输出格式（32位浮点）
+#define MIXER_SAMPLE_RATE 48000
+#define MIXER_CHANNELS 2
+/**
+ * @brief 将会话加入混音器，第一个会话加入时打开音频设备
+ *
+ * 会话的 sdl_spec 会设为混音器的格式，加入后处于暂停状态。
+*/
+int mixer_add_session(PlayerSession* session);
+/// @brief 将会话移出混音器，最后一个会话移出时关闭音频设备
+void mixer_remove_session(PlayerSession* session);
+void mixer_get_stats(PlayerMixerStats* stats);
+#if __cplusplus
+}
+#endif
+#endif
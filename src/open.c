@@ -1,45 +1,119 @@
 #include "open.h"
+#include "probe_cache.h"
+#include "seek_index.h"
+
+/// @brief 取消创建时让阻塞的读取立即返回
+static int interrupt_callback(void* opaque) {
+    return ((PlayerSession*)opaque)->interrupted;
+}
 
 int open_input(PlayerSession* session, const char* url) {
     if (!session || !url) return PLAYER_ERR_NULLPTR;
     int re = 0;
-    if ((re = avformat_open_input(&session->fmt, url, NULL, NULL)) < 0) {
+    const AVInputFormat* ifmt = NULL;
+    session->cached_audio_stream = PLAYER_STREAM_AUTO;
+    session->cached_video_stream = PLAYER_STREAM_AUTO;
+    if (session->settings->input_format) {
+        avdevice_register_all();
+        if (!(ifmt = av_find_input_format(session->settings->input_format))) {
+            av_log(NULL, AV_LOG_FATAL, "Unknown input format: %s\n", session->settings->input_format);
+            return AVERROR_DEMUXER_NOT_FOUND;
+        }
+    }
+    if (!(session->fmt = avformat_alloc_context())) {
+        return PLAYER_ERR_OOM;
+    }
+    session->fmt->interrupt_callback.callback = interrupt_callback;
+    session->fmt->interrupt_callback.opaque = session;
+    if (session->settings->low_latency) {
+        // 不缓存探测时读到的数据包，并缩短探测时间
+        session->fmt->flags |= AVFMT_FLAG_NOBUFFER;
+        session->fmt->max_analyze_duration = AV_TIME_BASE / 2;
+    }
+    if ((re = avformat_open_input(&session->fmt, url, ifmt, NULL)) < 0) {
         av_log(NULL, AV_LOG_FATAL, "Failed to open \"%s\": %s (%i)\n", url, av_err2str(re), re);
         return re;
     }
-    if ((re = avformat_find_stream_info(session->fmt, NULL)) < 0) {
+    // 命中探测缓存时不需要读取数据包来探测流信息
+    if (!probe_cache_apply(session, url) && (re = avformat_find_stream_info(session->fmt, NULL)) < 0) {
         av_log(NULL, AV_LOG_FATAL, "Failed to find streams in \"%s\": %s (%i)\n", url, av_err2str(re), re);
         return re;
     }
+    seek_index_open(session, url);
     return PLAYER_ERR_OK;
 }
 
-int find_audio_stream(PlayerSession* session) {
-    if (!session) return PLAYER_ERR_NULLPTR;
+/**
+ * @brief 查找指定类型的流
+ * @param index 指定的流序号，<0 时自动选择第一个可以解码的流
+*/
+static int find_stream(PlayerSession* session, enum AVMediaType type, int index, AVStream** stream) {
+    if (index == PLAYER_STREAM_DISABLED) return PLAYER_ERR_NO_STREAM_OR_DECODER;
+    if (index >= 0) {
+        if ((unsigned int)index >= session->fmt->nb_streams) {
+            av_log(NULL, AV_LOG_ERROR, "Stream %d does not exist.\n", index);
+            return PLAYER_ERR_INVALID_STREAM;
+        }
+        AVStream* is = session->fmt->streams[index];
+        if (is->codecpar->codec_type != type || !avcodec_find_decoder(is->codecpar->codec_id)) {
+            av_log(NULL, AV_LOG_ERROR, "Stream %d is not a decodable %s stream.\n", index, av_get_media_type_string(type));
+            return PLAYER_ERR_INVALID_STREAM;
+        }
+        *stream = is;
+        return PLAYER_ERR_OK;
+    }
     for (unsigned int i = 0; i < session->fmt->nb_streams; i++) {
         AVStream* is = session->fmt->streams[i];
-        if (is->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
+        // 附加图片只有一帧，不作为视频流播放
+        if (is->disposition & AV_DISPOSITION_ATTACHED_PIC) continue;
+        if (is->codecpar->codec_type == type) {
             if (!avcodec_find_decoder(is->codecpar->codec_id)) {
                 continue;
             }
-            session->audio_input_stream = is;
+            *stream = is;
             return PLAYER_ERR_OK;
         }
     }
     return PLAYER_ERR_NO_STREAM_OR_DECODER;
 }
 
+int find_audio_stream(PlayerSession* session) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    int index = session->settings->audio_stream_index;
+    // 自动选择时沿用缓存中记录的自动选择结果
+    if (index == PLAYER_STREAM_AUTO && session->cached_audio_stream >= 0) index = session->cached_audio_stream;
+    return find_stream(session, AVMEDIA_TYPE_AUDIO, index, &session->audio_input_stream);
+}
+
 int find_video_stream(PlayerSession* session) {
     if (!session) return PLAYER_ERR_NULLPTR;
+    int index = session->settings->video_stream_index;
+    if (index == PLAYER_STREAM_AUTO && session->cached_video_stream >= 0) index = session->cached_video_stream;
+    return find_stream(session, AVMEDIA_TYPE_VIDEO, index, &session->video_input_stream);
+}
+
+int find_cover_stream(PlayerSession* session, AVStream** stream) {
+    if (!session || !stream) return PLAYER_ERR_NULLPTR;
+    if (session->settings->video_stream_index == PLAYER_STREAM_DISABLED) return PLAYER_ERR_NO_STREAM_OR_DECODER;
     for (unsigned int i = 0; i < session->fmt->nb_streams; i++) {
         AVStream* is = session->fmt->streams[i];
-        if (is->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-            if (!avcodec_find_decoder(is->codecpar->codec_id)) {
-                continue;
-            }
-            session->video_input_stream = is;
+        if ((is->disposition & AV_DISPOSITION_ATTACHED_PIC) && is->attached_pic.size > 0 && avcodec_find_decoder(is->codecpar->codec_id)) {
+            *stream = is;
             return PLAYER_ERR_OK;
         }
     }
     return PLAYER_ERR_NO_STREAM_OR_DECODER;
 }
+
+void discard_unused_streams(PlayerSession* session) {
+    if (!session || !session->fmt) return;
+    for (unsigned int i = 0; i < session->fmt->nb_streams; i++) {
+        AVStream* is = session->fmt->streams[i];
+        if ((session->has_audio && is == session->audio_input_stream) || (session->has_video && is == session->video_input_stream)) {
+            is->discard = AVDISCARD_DEFAULT;
+        } else {
+            // 让 demuxer 直接跳过未使用的流
+            is->discard = AVDISCARD_ALL;
+        }
+    }
+}
@@ -7,6 +7,14 @@ extern "C" {
 int open_input(PlayerSession* session, const char* url);
 int find_audio_stream(PlayerSession* session);
 int find_video_stream(PlayerSession* session);
+/**
+ * @brief 查找封面（附加图片）流
+ *
+ * find_video_stream 自动选择时会跳过附加图片，没有其他视频流时再使用封面。
+*/
+int find_cover_stream(PlayerSession* session, AVStream** stream);
+/// @brief 将未选择的流设为 AVDISCARD_ALL
+void discard_unused_streams(PlayerSession* session);
 #if __cplusplus
 }
 #endif
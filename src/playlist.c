@@ -0,0 +1,342 @@
+#include "playlist.h"
+#include "open.h"
+#include "probe_cache.h"
+#include "seek_index.h"
+#include "decode.h"
+#include "audio_output.h"
+#include "filter.h"
+#include "video_output.h"
+
+static void free_item_contexts(PlayerSession* item) {
+    if (!item) return;
+    if (item->swrac) swr_free(&item->swrac);
+    av_frame_free(&item->cover_frame);
+    if (item->video_decoder) avcodec_free_context(&item->video_decoder);
+    if (item->audio_decoder) avcodec_free_context(&item->audio_decoder);
+    if (item->fmt) avformat_close_input(&item->fmt);
+    seek_index_free(&item->seek_index_builder);
+}
+
+int enqueue_next_item(PlayerSession* session, const char* url) {
+    if (!session || !url) return PLAYER_ERR_NULLPTR;
+    if (session->next) return PLAYER_ERR_NEXT_ITEM_PENDING;
+    PlayerSession* next = (PlayerSession*)malloc(sizeof(PlayerSession));
+    if (!next) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to allocate memory for next item.\n");
+        return PLAYER_ERR_OOM;
+    }
+    memset(next, 0, sizeof(PlayerSession));
+    next->settings = session->settings;
+    if (!(session->next_url = av_strdup(url))) {
+        free(next);
+        return PLAYER_ERR_OOM;
+    }
+    // 先挂起线程，保证线程开始运行前 next 已经设置
+    session->preload_thread = CreateThread(NULL, 0, preload_loop, session, CREATE_SUSPENDED, NULL);
+    if (!session->preload_thread) {
+        av_freep(&session->next_url);
+        free(next);
+        return PLAYER_ERR_FAILED_CREATE_THREAD;
+    }
+    session->next = next;
+    ResumeThread(session->preload_thread);
+    return PLAYER_ERR_OK;
+}
+
+int next_item_is_ready(PlayerSession* session) {
+    if (!session || !session->next || !session->preload_thread) return 0;
+    if (WaitForSingleObject(session->preload_thread, 0) != WAIT_OBJECT_0) return 0;
+    if (session->next->err) {
+        char* msg = player_get_err_msg(session->next->err);
+        av_log(NULL, AV_LOG_ERROR, "Failed to preload \"%s\": %s\n", session->next_url, msg ? msg : "Unknown error");
+        if (msg) free(msg);
+        free_next_item(session);
+        return 0;
+    }
+    return 1;
+}
+
+/// @brief 流的开始时间（单位：微秒），未知时使用文件的开始时间
+static int64_t stream_start_time(AVFormatContext* fmt, AVStream* st) {
+    if (st && st->start_time != AV_NOPTS_VALUE) return av_rescale_q(st->start_time, st->time_base, AV_TIME_BASE_Q);
+    return fmt->start_time != AV_NOPTS_VALUE ? fmt->start_time : 0;
+}
+
+/**
+ * @brief 按下一个文件的开始时间重新计算 first_pts 和 video_first_pts
+ *
+ * 缓冲区中仍有上一个文件的数据，时间轴继续：下一个文件的开始对应缓冲数据的结束位置。
+ * 两者平移相同的距离，音视频的时间差不变，播放位置不会跳变。
+ * 需要持有两个互斥锁，在替换流之前调用。
+*/
+static void rebase_first_pts(PlayerSession* session, PlayerSession* next) {
+    if (session->has_audio && session->first_pts != INT64_MIN) {
+        int64_t first_pts = stream_start_time(next->fmt, next->audio_input_stream) - session->end_pts;
+        if (session->video_first_pts != INT64_MIN) session->video_first_pts += first_pts - session->first_pts;
+        session->first_pts = first_pts;
+    } else if (session->has_video && session->video_first_pts != INT64_MIN) {
+        // 没有音频时以缓冲区最后一帧的结束位置为准
+        int64_t end = session->video_pts;
+        AVFrame* frame;
+        size_t count = av_fifo_can_read(session->video_buffer);
+        if (count && av_fifo_peek(session->video_buffer, &frame, 1, count - 1) >= 0 && frame->pts != AV_NOPTS_VALUE) {
+            end = av_rescale_q_rnd(frame->pts + FFMAX(frame->duration, 0), session->video_input_stream->time_base, AV_TIME_BASE_Q, AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX) - session->video_first_pts;
+        }
+        session->video_first_pts = stream_start_time(next->fmt, next->video_input_stream) - end;
+    }
+}
+
+int switch_to_next_item(PlayerSession* session) {
+    if (!session || !session->next) return PLAYER_ERR_NULLPTR;
+    PlayerSession* next = session->next;
+    PlayerSession old;
+    PlayerSession filters;
+    // 滤镜的输入格式与解码器相关，先为下一个文件创建，失败时当前文件保持不变
+    memset(&filters, 0, sizeof(PlayerSession));
+    filters.settings = session->settings;
+    filters.has_audio = next->has_audio;
+    filters.has_video = next->has_video;
+    filters.audio_input_stream = next->audio_input_stream;
+    filters.audio_decoder = next->reuse_audio_decoder ? session->audio_decoder : next->audio_decoder;
+    filters.video_input_stream = next->video_input_stream;
+    filters.video_decoder = next->reuse_video_decoder ? session->video_decoder : next->video_decoder;
+    int re = init_audio_filter(&filters);
+    if (!re) re = init_video_filter(&filters);
+    if (re) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to create filters for next item: %s (%i)\n", av_err2str(re), re);
+        free_filters(&filters);
+        free_next_item(session);
+        return re;
+    }
+    DWORD res = WaitForSingleObject(session->mutex, INFINITE);
+    if (res != WAIT_OBJECT_0) {
+        free_filters(&filters);
+        return PLAYER_ERR_WAIT_MUTEX_FAILED;
+    }
+    res = WaitForSingleObject(session->video_mutex, INFINITE);
+    if (res != WAIT_OBJECT_0) {
+        ReleaseMutex(session->mutex);
+        free_filters(&filters);
+        return PLAYER_ERR_WAIT_MUTEX_FAILED;
+    }
+    memset(&old, 0, sizeof(PlayerSession));
+    rebase_first_pts(session, next);
+    old.fmt = session->fmt;
+    session->fmt = next->fmt;
+    // 中断回调仍指向预加载用的临时会话，切换后该会话会被释放
+    session->fmt->interrupt_callback.opaque = session;
+    old.seek_index_builder = session->seek_index_builder;
+    session->seek_index_builder = next->seek_index_builder;
+    session->seek_index_duration = next->seek_index_duration;
+    session->audio_input_stream = next->audio_input_stream;
+    if (next->reuse_audio_decoder) {
+        // 解码参数相同，只需清空解码器内部的数据，重采样设置也不变
+        avcodec_flush_buffers(session->audio_decoder);
+    } else {
+        old.swrac = session->swrac;
+        old.audio_decoder = session->audio_decoder;
+        session->audio_codec = next->audio_codec;
+        session->audio_decoder = next->audio_decoder;
+        session->swrac = next->swrac;
+    }
+    session->video_input_stream = next->video_input_stream;
+    if (next->reuse_video_decoder) {
+        avcodec_flush_buffers(session->video_decoder);
+    } else {
+        old.video_decoder = session->video_decoder;
+        session->video_codec = next->video_codec;
+        session->video_decoder = next->video_decoder;
+    }
+    // 缓冲区中仍保留着上一个文件的尾部数据，时间轴直接延续
+    session->audio_is_eof = 0;
+    session->video_is_eof = 0;
+    session->demux_is_eof = 0;
+    session->video_decoder_flushed = 0;
+    session->video_skip_until_key = 0;
+    // 新的解码器使用默认设置，需要重新应用跳帧等级
+    if (next->reuse_video_decoder) apply_video_skip_level(session);
+    else session->applied_video_skip_level = 0;
+    free_filters(session);
+    session->audio_filter_graph = filters.audio_filter_graph;
+    session->audio_filter_src = filters.audio_filter_src;
+    session->audio_filter_sink = filters.audio_filter_sink;
+    session->video_filter_graph = filters.video_filter_graph;
+    session->video_filter_src = filters.video_filter_src;
+    session->video_filter_sink = filters.video_filter_sink;
+    if (next->has_video) session->video_frame_rate = filters.video_frame_rate;
+    if (session->has_cover) {
+        // 封面纹理只能在事件线程中更新，交给事件线程替换
+        av_frame_free(&session->pending_cover);
+        session->pending_cover = next->cover_frame;
+        session->cover_stream = next->cover_stream;
+        session->cover_changed = 1;
+        next->cover_frame = NULL;
+    }
+    session->item_index++;
+    ReleaseMutex(session->video_mutex);
+    ReleaseMutex(session->mutex);
+    if (session->has_cover) request_video_refresh(session);
+    av_log(NULL, AV_LOG_VERBOSE, "Switched to next item: %s\n", session->next_url);
+    next->fmt = NULL;
+    next->seek_index_builder = NULL;
+    next->swrac = NULL;
+    next->audio_decoder = NULL;
+    next->video_decoder = NULL;
+    free_item_contexts(&old);
+    free_next_item(session);
+    return re;
+}
+
+void free_next_item(PlayerSession* session) {
+    if (!session) return;
+    if (session->preload_thread) {
+        WaitForSingleObject(session->preload_thread, INFINITE);
+        CloseHandle(session->preload_thread);
+        session->preload_thread = NULL;
+    }
+    if (session->next) {
+        free_item_contexts(session->next);
+        free(session->next);
+        session->next = NULL;
+    }
+    av_freep(&session->next_url);
+}
+
+/**
+ * @brief 判断两个流的解码参数是否相同，相同时解码器可以直接复用
+*/
+static int codec_parameters_equal(AVCodecParameters* a, AVCodecParameters* b) {
+    if (!a || !b) return 0;
+    if (a->codec_type != b->codec_type || a->codec_id != b->codec_id || a->codec_tag != b->codec_tag || a->format != b->format) return 0;
+    if (a->profile != b->profile || a->level != b->level) return 0;
+    // 部分解码器（如 PCM、ADPCM、原始视频）按这些字段解析数据
+    if (a->bits_per_coded_sample != b->bits_per_coded_sample || a->bits_per_raw_sample != b->bits_per_raw_sample) return 0;
+    if (a->extradata_size != b->extradata_size) return 0;
+    if (a->extradata_size && memcmp(a->extradata, b->extradata, a->extradata_size)) return 0;
+    if (a->codec_type == AVMEDIA_TYPE_AUDIO) {
+        return a->sample_rate == b->sample_rate && !av_channel_layout_compare(&a->ch_layout, &b->ch_layout) && a->block_align == b->block_align && a->frame_size == b->frame_size;
+    }
+    return a->width == b->width && a->height == b->height && !av_cmp_q(a->sample_aspect_ratio, b->sample_aspect_ratio) && a->field_order == b->field_order &&
+        a->color_range == b->color_range && a->color_space == b->color_space && a->color_primaries == b->color_primaries && a->color_trc == b->color_trc && a->chroma_location == b->chroma_location;
+}
+
+/**
+ * @brief 打开文件和解码器，输出到 h 已打开的音频设备格式
+ * @param allow_reuse 解码参数相同时是否复用 h 的解码器（只能在解码线程暂停时使用）
+*/
+static int load_item(PlayerSession* h, PlayerSession* n, const char* url, int allow_reuse) {
+    int re = PLAYER_ERR_OK;
+    if ((re = open_input(n, url))) {
+        return re;
+    }
+    av_dump_format(n->fmt, 0, url, 0);
+    // 需要与当前文件有相同的流，才能复用音频设备和窗口
+    if (h->has_audio) {
+        if ((re = find_audio_stream(n))) {
+            if (re == PLAYER_ERR_NO_STREAM_OR_DECODER || re == PLAYER_ERR_INVALID_STREAM) re = PLAYER_ERR_INCOMPATIBLE_NEXT_ITEM;
+            return re;
+        }
+        n->has_audio = 1;
+    }
+    if (h->has_video) {
+        if ((re = find_video_stream(n))) {
+            if (re == PLAYER_ERR_NO_STREAM_OR_DECODER || re == PLAYER_ERR_INVALID_STREAM) re = PLAYER_ERR_INCOMPATIBLE_NEXT_ITEM;
+            return re;
+        }
+        n->has_video = 1;
+    }
+    // 显示封面的会话换上新文件的封面，新文件没有封面时显示黑色
+    if (h->has_cover && !find_cover_stream(n, &n->cover_stream)) decode_cover(n);
+    discard_unused_streams(n);
+    probe_cache_store(n, url);
+    if (allow_reuse && n->has_audio && codec_parameters_equal(h->audio_input_stream->codecpar, n->audio_input_stream->codecpar)) {
+        n->reuse_audio_decoder = 1;
+        av_log(NULL, AV_LOG_VERBOSE, "Reuse audio decoder.\n");
+    } else if ((re = open_audio_decoder(n))) {
+        return re;
+    }
+    if (allow_reuse && n->has_video && codec_parameters_equal(h->video_input_stream->codecpar, n->video_input_stream->codecpar)) {
+        n->reuse_video_decoder = 1;
+        av_log(NULL, AV_LOG_VERBOSE, "Reuse video decoder.\n");
+    } else if ((re = open_video_decoder(n))) {
+        return re;
+    }
+    if (n->has_audio && !n->reuse_audio_decoder) {
+        // 输出到当前已打开的音频设备格式
+        re = init_audio_resampler(h, n->audio_decoder, &n->swrac);
+    }
+    return re;
+}
+
+DWORD WINAPI preload_loop(LPVOID handle) {
+    if (!handle) return PLAYER_ERR_NULLPTR;
+    PlayerSession* h = (PlayerSession*)handle;
+    PlayerSession* n = h->next;
+    int re = load_item(h, n, h->next_url, 0);
+    n->err = re;
+    return re;
+}
+
+int open_item(PlayerSession* session, const char* url) {
+    if (!session || !url) return PLAYER_ERR_NULLPTR;
+    if (session->next) return PLAYER_ERR_NEXT_ITEM_PENDING;
+    PlayerSession* next = (PlayerSession*)malloc(sizeof(PlayerSession));
+    int re = PLAYER_ERR_OK;
+    if (!next) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to allocate memory for next item.\n");
+        return PLAYER_ERR_OOM;
+    }
+    memset(next, 0, sizeof(PlayerSession));
+    next->settings = session->settings;
+    if (!(session->next_url = av_strdup(url))) {
+        free(next);
+        return PLAYER_ERR_OOM;
+    }
+    session->next = next;
+    if ((re = load_item(session, next, url, 1))) {
+        free_next_item(session);
+        return re;
+    }
+    if ((re = switch_to_next_item(session))) {
+        return re;
+    }
+    // 丢弃上一个文件缓冲的数据，从新文件的开头播放
+    if (WaitForSingleObject(session->mutex, INFINITE) != WAIT_OBJECT_0) {
+        return PLAYER_ERR_WAIT_MUTEX_FAILED;
+    }
+    if (WaitForSingleObject(session->video_mutex, INFINITE) != WAIT_OBJECT_0) {
+        ReleaseMutex(session->mutex);
+        return PLAYER_ERR_WAIT_MUTEX_FAILED;
+    }
+    if (session->buffer) av_audio_fifo_reset(session->buffer);
+    if (session->video_buffer) {
+        AVFrame* frame;
+        while (av_fifo_read(session->video_buffer, &frame, 1) >= 0) {
+            av_frame_free(&frame);
+        }
+    }
+    flush_video_packets(session);
+    session->first_pts = INT64_MIN;
+    session->video_first_pts = INT64_MIN;
+    session->next_video_timestamp = INT64_MIN;
+    session->last_pts_timestamp = INT64_MIN;
+    session->clock_start_timestamp = INT64_MIN;
+    session->clock_paused_pos = 0;
+    session->pts = 0;
+    session->end_pts = 0;
+    session->video_pts = 0;
+    session->video_end_pts = 0;
+    session->last_pkt_pts = 0;
+    session->video_head_displayed = 0;
+    session->skip_late_ticks = 0;
+    session->skip_ontime_ticks = 0;
+    session->live_catching_up = 0;
+    session->requested_audio_stream = -1;
+    if (session->has_video && session->video_decoder) {
+        session->video_skip_level = 0;
+        apply_video_skip_level(session);
+    }
+    ReleaseMutex(session->video_mutex);
+    ReleaseMutex(session->mutex);
+    return PLAYER_ERR_OK;
+}
@@ -0,0 +1,21 @@
+#ifndef _PLAYER_PLAYLIST_H
+#define _PLAYER_PLAYLIST_H
+#if __cplusplus
+extern "C" {
+#endif
+#include "core.h"
+int enqueue_next_item(PlayerSession* session, const char* url);
+int next_item_is_ready(PlayerSession* session);
+int switch_to_next_item(PlayerSession* session);
+void free_next_item(PlayerSession* session);
+/**
+ * @brief 立即替换为另一个文件，保留音频设备、窗口、线程，参数相同时保留解码器
+ *
+ * 需要在解码线程暂停时调用，会丢弃所有缓冲的数据。
+*/
+int open_item(PlayerSession* session, const char* url);
+DWORD WINAPI preload_loop(LPVOID handle);
+#if __cplusplus
+}
+#endif
+#endif
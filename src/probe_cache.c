@@ -0,0 +1,330 @@
+#include "probe_cache.h"
+#include "libavutil/md5.h"
+
+#define PROBE_CACHE_MAGIC MKTAG('P', 'P', 'C', 'H')
+#define PROBE_CACHE_END MKTAG('P', 'P', 'C', 'E')
+#define PROBE_CACHE_VERSION 2
+/// 超过该大小的 extradata 视为缓存损坏
+#define PROBE_CACHE_MAX_EXTRADATA (16 * 1024 * 1024)
+
+static volatile LONG64 probe_cache_hits = 0;
+static volatile LONG64 probe_cache_misses = 0;
+
+typedef struct CachedStream {
+    AVCodecParameters* par;
+    AVRational time_base;
+    AVRational avg_frame_rate;
+    AVRational r_frame_rate;
+    int64_t start_time;
+    int64_t duration;
+    int64_t nb_frames;
+    int disposition;
+} CachedStream;
+
+wchar_t* utf8_to_wide(const char* s) {
+    int len = MultiByteToWideChar(CP_UTF8, 0, s, -1, NULL, 0);
+    if (len <= 0) return NULL;
+    wchar_t* w = (wchar_t*)av_malloc_array(len, sizeof(wchar_t));
+    if (!w) return NULL;
+    if (!MultiByteToWideChar(CP_UTF8, 0, s, -1, w, len)) {
+        av_free(w);
+        return NULL;
+    }
+    return w;
+}
+
+/// @brief 是否可以使用缓存（只缓存本地文件，指定输入格式或低延迟模式时不使用）
+static int probe_cache_enabled(PlayerSession* session) {
+    PlayerSettings* s = session->settings;
+    return s->probe_cache && !s->input_format && !s->low_latency;
+}
+
+int get_local_file_key(const char* url, LocalFileKey* key) {
+    if (av_strstart(url, "file:", &url)) {
+        // file: 协议等同于本地路径
+    } else if (strstr(url, "://")) {
+        return 0;
+    }
+    wchar_t* w = utf8_to_wide(url);
+    if (!w) return 0;
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    BOOL ok = GetFileAttributesExW(w, GetFileExInfoStandard, &data);
+    av_free(w);
+    if (!ok || (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) return 0;
+    key->size = ((int64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    key->mtime = ((int64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+    return 1;
+}
+
+char* get_cache_file_path(const char* dir, const char* url, const char* ext) {
+    uint8_t md5[16];
+    char hex[33];
+    av_md5_sum(md5, (const uint8_t*)url, strlen(url));
+    for (int i = 0; i < 16; i++) snprintf(hex + i * 2, 3, "%02x", md5[i]);
+    return av_asprintf("%s/%s.%s", dir, hex, ext);
+}
+
+int replace_cache_file(const char* tmp, const char* path) {
+    wchar_t* wtmp = utf8_to_wide(tmp);
+    wchar_t* wpath = utf8_to_wide(path);
+    int ok = wtmp && wpath && MoveFileExW(wtmp, wpath, MOVEFILE_REPLACE_EXISTING);
+    if (!ok && wtmp) DeleteFileW(wtmp);
+    av_free(wtmp);
+    av_free(wpath);
+    return ok;
+}
+
+static void write_codecpar(AVIOContext* pb, const AVCodecParameters* p) {
+    avio_wl32(pb, p->codec_type);
+    avio_wl32(pb, p->codec_id);
+    avio_wl32(pb, p->codec_tag);
+    avio_wl32(pb, p->format);
+    avio_wl64(pb, p->bit_rate);
+    avio_wl32(pb, p->bits_per_coded_sample);
+    avio_wl32(pb, p->bits_per_raw_sample);
+    avio_wl32(pb, p->profile);
+    avio_wl32(pb, p->level);
+    avio_wl32(pb, p->width);
+    avio_wl32(pb, p->height);
+    avio_wl32(pb, p->sample_aspect_ratio.num);
+    avio_wl32(pb, p->sample_aspect_ratio.den);
+    avio_wl32(pb, p->field_order);
+    avio_wl32(pb, p->color_range);
+    avio_wl32(pb, p->color_primaries);
+    avio_wl32(pb, p->color_trc);
+    avio_wl32(pb, p->color_space);
+    avio_wl32(pb, p->chroma_location);
+    avio_wl32(pb, p->video_delay);
+    avio_wl32(pb, p->ch_layout.order);
+    avio_wl32(pb, p->ch_layout.nb_channels);
+    avio_wl64(pb, p->ch_layout.order == AV_CHANNEL_ORDER_NATIVE || p->ch_layout.order == AV_CHANNEL_ORDER_AMBISONIC ? p->ch_layout.u.mask : 0);
+    avio_wl32(pb, p->sample_rate);
+    avio_wl32(pb, p->block_align);
+    avio_wl32(pb, p->frame_size);
+    avio_wl32(pb, p->initial_padding);
+    avio_wl32(pb, p->trailing_padding);
+    avio_wl32(pb, p->seek_preroll);
+    avio_wl32(pb, p->extradata_size);
+    if (p->extradata_size > 0) avio_write(pb, p->extradata, p->extradata_size);
+}
+
+static int read_codecpar(AVIOContext* pb, AVCodecParameters* p) {
+    p->codec_type = (enum AVMediaType)(int)avio_rl32(pb);
+    p->codec_id = (enum AVCodecID)avio_rl32(pb);
+    p->codec_tag = avio_rl32(pb);
+    p->format = (int)avio_rl32(pb);
+    p->bit_rate = (int64_t)avio_rl64(pb);
+    p->bits_per_coded_sample = (int)avio_rl32(pb);
+    p->bits_per_raw_sample = (int)avio_rl32(pb);
+    p->profile = (int)avio_rl32(pb);
+    p->level = (int)avio_rl32(pb);
+    p->width = (int)avio_rl32(pb);
+    p->height = (int)avio_rl32(pb);
+    p->sample_aspect_ratio.num = (int)avio_rl32(pb);
+    p->sample_aspect_ratio.den = (int)avio_rl32(pb);
+    p->field_order = (enum AVFieldOrder)avio_rl32(pb);
+    p->color_range = (enum AVColorRange)avio_rl32(pb);
+    p->color_primaries = (enum AVColorPrimaries)avio_rl32(pb);
+    p->color_trc = (enum AVColorTransferCharacteristic)avio_rl32(pb);
+    p->color_space = (enum AVColorSpace)avio_rl32(pb);
+    p->chroma_location = (enum AVChromaLocation)avio_rl32(pb);
+    p->video_delay = (int)avio_rl32(pb);
+    enum AVChannelOrder order = (enum AVChannelOrder)avio_rl32(pb);
+    int nb_channels = (int)avio_rl32(pb);
+    uint64_t mask = avio_rl64(pb);
+    av_channel_layout_uninit(&p->ch_layout);
+    if (order == AV_CHANNEL_ORDER_NATIVE || order == AV_CHANNEL_ORDER_AMBISONIC) {
+        p->ch_layout.order = order;
+        p->ch_layout.nb_channels = nb_channels;
+        p->ch_layout.u.mask = mask;
+    } else if (order == AV_CHANNEL_ORDER_CUSTOM && nb_channels > 0) {
+        // 自定义声道映射没有保存，使用默认布局
+        av_channel_layout_default(&p->ch_layout, nb_channels);
+    } else {
+        p->ch_layout.order = AV_CHANNEL_ORDER_UNSPEC;
+        p->ch_layout.nb_channels = nb_channels;
+    }
+    p->sample_rate = (int)avio_rl32(pb);
+    p->block_align = (int)avio_rl32(pb);
+    p->frame_size = (int)avio_rl32(pb);
+    p->initial_padding = (int)avio_rl32(pb);
+    p->trailing_padding = (int)avio_rl32(pb);
+    p->seek_preroll = (int)avio_rl32(pb);
+    int extradata_size = (int)avio_rl32(pb);
+    if (extradata_size < 0 || extradata_size > PROBE_CACHE_MAX_EXTRADATA) return AVERROR_INVALIDDATA;
+    if (extradata_size > 0) {
+        if (!(p->extradata = (uint8_t*)av_mallocz(extradata_size + AV_INPUT_BUFFER_PADDING_SIZE))) return AVERROR(ENOMEM);
+        p->extradata_size = extradata_size;
+        if (avio_read(pb, p->extradata, extradata_size) != extradata_size) return AVERROR_INVALIDDATA;
+    }
+    return pb->eof_reached ? AVERROR_INVALIDDATA : 0;
+}
+
+static void free_cached_streams(CachedStream* streams, unsigned int count) {
+    if (!streams) return;
+    for (unsigned int i = 0; i < count; i++) {
+        if (streams[i].par) avcodec_parameters_free(&streams[i].par);
+    }
+    av_free(streams);
+}
+
+/**
+ * @brief 读取缓存文件并应用到 fmt
+ * @return 成功返回0
+*/
+static int read_cache(PlayerSession* session, AVIOContext* pb, const char* url, const LocalFileKey* key) {
+    AVFormatContext* fmt = session->fmt;
+    CachedStream* streams = NULL;
+    unsigned int nb_streams = 0;
+    int re = AVERROR_INVALIDDATA;
+    if (avio_rl32(pb) != PROBE_CACHE_MAGIC || avio_rl32(pb) != PROBE_CACHE_VERSION) return re;
+    unsigned int url_len = avio_rl32(pb);
+    if (url_len != strlen(url)) return re;
+    char* cached_url = (char*)av_malloc(url_len + 1);
+    if (!cached_url) return AVERROR(ENOMEM);
+    int url_ok = avio_read(pb, (unsigned char*)cached_url, url_len) == (int)url_len;
+    cached_url[url_len] = 0;
+    url_ok = url_ok && !strcmp(cached_url, url);
+    av_free(cached_url);
+    if (!url_ok) return re;
+    // 文件已被修改
+    if ((int64_t)avio_rl64(pb) != key->size || (int64_t)avio_rl64(pb) != key->mtime) return re;
+    int64_t duration = (int64_t)avio_rl64(pb);
+    int64_t start_time = (int64_t)avio_rl64(pb);
+    int64_t bit_rate = (int64_t)avio_rl64(pb);
+    int audio_index = (int)avio_rl32(pb);
+    int video_index = (int)avio_rl32(pb);
+    nb_streams = avio_rl32(pb);
+    // 流在探测时才创建的格式（如 mpegts）无法使用缓存
+    if (nb_streams != fmt->nb_streams || !nb_streams) return re;
+    if (!(streams = (CachedStream*)av_calloc(nb_streams, sizeof(CachedStream)))) return AVERROR(ENOMEM);
+    for (unsigned int i = 0; i < nb_streams; i++) {
+        CachedStream* cs = &streams[i];
+        if (!(cs->par = avcodec_parameters_alloc())) {
+            re = AVERROR(ENOMEM);
+            goto end;
+        }
+        if ((re = read_codecpar(pb, cs->par)) < 0) goto end;
+        re = AVERROR_INVALIDDATA;
+        cs->time_base.num = (int)avio_rl32(pb);
+        cs->time_base.den = (int)avio_rl32(pb);
+        cs->start_time = (int64_t)avio_rl64(pb);
+        cs->duration = (int64_t)avio_rl64(pb);
+        cs->nb_frames = (int64_t)avio_rl64(pb);
+        cs->avg_frame_rate.num = (int)avio_rl32(pb);
+        cs->avg_frame_rate.den = (int)avio_rl32(pb);
+        cs->r_frame_rate.num = (int)avio_rl32(pb);
+        cs->r_frame_rate.den = (int)avio_rl32(pb);
+        cs->disposition = (int)avio_rl32(pb);
+        AVStream* st = fmt->streams[i];
+        // demuxer 读取文件头得到的信息需要与缓存一致
+        if (st->codecpar->codec_type != AVMEDIA_TYPE_UNKNOWN && st->codecpar->codec_type != cs->par->codec_type) goto end;
+        if (st->codecpar->codec_id != AV_CODEC_ID_NONE && st->codecpar->codec_id != cs->par->codec_id) goto end;
+        if (av_cmp_q(st->time_base, cs->time_base)) goto end;
+    }
+    if (avio_rl32(pb) != PROBE_CACHE_END || pb->eof_reached || pb->error) goto end;
+    for (unsigned int i = 0; i < nb_streams; i++) {
+        CachedStream* cs = &streams[i];
+        AVStream* st = fmt->streams[i];
+        if ((re = avcodec_parameters_copy(st->codecpar, cs->par)) < 0) goto end;
+        st->start_time = cs->start_time;
+        st->duration = cs->duration;
+        st->nb_frames = cs->nb_frames;
+        st->avg_frame_rate = cs->avg_frame_rate;
+        st->r_frame_rate = cs->r_frame_rate;
+        st->disposition = cs->disposition;
+    }
+    fmt->duration = duration;
+    fmt->start_time = start_time;
+    fmt->bit_rate = bit_rate;
+    session->cached_audio_stream = audio_index;
+    session->cached_video_stream = video_index;
+    re = 0;
+end:
+    free_cached_streams(streams, nb_streams);
+    return re;
+}
+
+int probe_cache_apply(PlayerSession* session, const char* url) {
+    if (!session || !url || !session->fmt || !probe_cache_enabled(session)) return 0;
+    LocalFileKey key;
+    if (!get_local_file_key(url, &key)) return 0;
+    char* path = get_cache_file_path(session->settings->probe_cache, url, "probe");
+    if (!path) return 0;
+    AVIOContext* pb = NULL;
+    int re = avio_open2(&pb, path, AVIO_FLAG_READ, NULL, NULL);
+    if (re >= 0) {
+        re = read_cache(session, pb, url, &key);
+        avio_closep(&pb);
+    }
+    if (re < 0) {
+        InterlockedIncrement64(&probe_cache_misses);
+        av_log(NULL, AV_LOG_VERBOSE, "Probe cache miss: %s\n", path);
+        av_free(path);
+        return 0;
+    }
+    InterlockedIncrement64(&probe_cache_hits);
+    av_log(NULL, AV_LOG_VERBOSE, "Probe cache hit: %s\n", path);
+    av_free(path);
+    session->probe_cache_hit = 1;
+    return 1;
+}
+
+void probe_cache_store(PlayerSession* session, const char* url) {
+    if (!session || !url || !session->fmt || session->probe_cache_hit || !probe_cache_enabled(session)) return;
+    AVFormatContext* fmt = session->fmt;
+    if (fmt->ctx_flags & AVFMTCTX_NOHEADER) return;
+    LocalFileKey key;
+    if (!get_local_file_key(url, &key)) return;
+    char* path = get_cache_file_path(session->settings->probe_cache, url, "probe");
+    if (!path) return;
+    char* tmp = av_asprintf("%s.tmp", path);
+    AVIOContext* pb = NULL;
+    if (!tmp || avio_open2(&pb, tmp, AVIO_FLAG_WRITE, NULL, NULL) < 0) {
+        av_log(NULL, AV_LOG_WARNING, "Failed to write probe cache: %s\n", path);
+        goto end;
+    }
+    size_t url_len = strlen(url);
+    avio_wl32(pb, PROBE_CACHE_MAGIC);
+    avio_wl32(pb, PROBE_CACHE_VERSION);
+    avio_wl32(pb, (unsigned int)url_len);
+    avio_write(pb, (const unsigned char*)url, (int)url_len);
+    avio_wl64(pb, key.size);
+    avio_wl64(pb, key.mtime);
+    avio_wl64(pb, fmt->duration);
+    avio_wl64(pb, fmt->start_time);
+    avio_wl64(pb, fmt->bit_rate);
+    // 只记录自动选择的结果，显式指定的流序号不能影响之后自动选择的打开
+    avio_wl32(pb, session->has_audio && session->settings->audio_stream_index == PLAYER_STREAM_AUTO ? session->audio_input_stream->index : PLAYER_STREAM_AUTO);
+    avio_wl32(pb, session->has_video && session->settings->video_stream_index == PLAYER_STREAM_AUTO ? session->video_input_stream->index : PLAYER_STREAM_AUTO);
+    avio_wl32(pb, fmt->nb_streams);
+    for (unsigned int i = 0; i < fmt->nb_streams; i++) {
+        AVStream* st = fmt->streams[i];
+        write_codecpar(pb, st->codecpar);
+        avio_wl32(pb, st->time_base.num);
+        avio_wl32(pb, st->time_base.den);
+        avio_wl64(pb, st->start_time);
+        avio_wl64(pb, st->duration);
+        avio_wl64(pb, st->nb_frames);
+        avio_wl32(pb, st->avg_frame_rate.num);
+        avio_wl32(pb, st->avg_frame_rate.den);
+        avio_wl32(pb, st->r_frame_rate.num);
+        avio_wl32(pb, st->r_frame_rate.den);
+        avio_wl32(pb, st->disposition);
+    }
+    avio_wl32(pb, PROBE_CACHE_END);
+    int error = pb->error;
+    avio_closep(&pb);
+    // 写完后再替换，其他会话不会读到不完整的文件
+    if (error < 0 || !replace_cache_file(tmp, path)) {
+        av_log(NULL, AV_LOG_WARNING, "Failed to write probe cache: %s\n", path);
+    }
+end:
+    av_free(tmp);
+    av_free(path);
+}
+
+void probe_cache_get_stats(uint64_t* hits, uint64_t* misses) {
+    if (hits) *hits = (uint64_t)InterlockedCompareExchange64(&probe_cache_hits, 0, 0);
+    if (misses) *misses = (uint64_t)InterlockedCompareExchange64(&probe_cache_misses, 0, 0);
+}
@@ -0,0 +1,38 @@
+#ifndef _PLAYER_PROBE_CACHE_H
+#define _PLAYER_PROBE_CACHE_H
+#if __cplusplus
+extern "C" {
+#endif
+#include "core.h"
+
+typedef struct LocalFileKey {
+    int64_t size;
+    /// @brief 修改时间（FILETIME）
+    int64_t mtime;
+} LocalFileKey;
+
+/// @brief 转换 UTF-8 字符串，返回值需要用 av_free 释放
+wchar_t* utf8_to_wide(const char* s);
+/// @brief 获取本地文件的大小和修改时间，不是本地文件时返回0
+int get_local_file_key(const char* url, LocalFileKey* key);
+/// @brief 缓存文件路径为 <dir>/<url 的 MD5>.<ext>
+char* get_cache_file_path(const char* dir, const char* url, const char* ext);
+/**
+ * @brief 用写好的临时文件替换缓存文件，其他会话不会读到不完整的文件
+ * @return 成功返回1，失败时删除临时文件并返回0
+*/
+int replace_cache_file(const char* tmp, const char* path);
+/**
+ * @brief 查找探测缓存并应用到已打开的 fmt 上
+ *
+ * 以路径、文件大小和修改时间为键，命中时可以跳过 avformat_find_stream_info。
+ * @return 命中返回1，否则返回0
+*/
+int probe_cache_apply(PlayerSession* session, const char* url);
+/// @brief 将探测结果和选择的流写入缓存（命中缓存或未启用缓存时不写入）
+void probe_cache_store(PlayerSession* session, const char* url);
+void probe_cache_get_stats(uint64_t* hits, uint64_t* misses);
+#if __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,197 @@
+#include "render.h"
+#include "decode.h"
+#include "video_output.h"
+#include "libavutil/intreadwrite.h"
+
+static int write_wav_header(FILE* f, PlayerSession* session, uint64_t data_size) {
+    uint8_t header[44];
+    uint16_t channels = session->sdl_spec.channels;
+    uint16_t bits = session->target_format_pbytes * 8;
+    uint16_t block_align = channels * session->target_format_pbytes;
+    uint32_t size = data_size > UINT32_MAX - 36 ? UINT32_MAX - 36 : (uint32_t)data_size;
+    memcpy(header, "RIFF", 4);
+    AV_WL32(header + 4, size + 36);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    AV_WL32(header + 16, 16);
+    // 1: PCM 3: IEEE float
+    AV_WL16(header + 20, session->target_format == AV_SAMPLE_FMT_FLT ? 3 : 1);
+    AV_WL16(header + 22, channels);
+    AV_WL32(header + 24, session->sdl_spec.freq);
+    AV_WL32(header + 28, session->sdl_spec.freq * block_align);
+    AV_WL16(header + 32, block_align);
+    AV_WL16(header + 34, bits);
+    memcpy(header + 36, "data", 4);
+    AV_WL32(header + 40, size);
+    if (fseek(f, 0, SEEK_SET)) return AVERROR(errno);
+    if (fwrite(header, 1, sizeof(header), f) != sizeof(header)) return AVERROR(EIO);
+    return PLAYER_ERR_OK;
+}
+
+static int write_y4m_frame(FILE* f, AVFrame* frame, int write_header, AVRational rate) {
+    if (write_header) {
+        AVRational sar = frame->sample_aspect_ratio.num ? frame->sample_aspect_ratio : av_make_q(1, 1);
+        fprintf(f, "YUV4MPEG2 W%d H%d F%d:%d Ip A%d:%d C420jpeg\n", frame->width, frame->height, rate.num, rate.den, sar.num, sar.den);
+    }
+    fputs("FRAME\n", f);
+    for (int i = 0; i < 3; i++) {
+        int w = i ? AV_CEIL_RSHIFT(frame->width, 1) : frame->width;
+        int h = i ? AV_CEIL_RSHIFT(frame->height, 1) : frame->height;
+        for (int y = 0; y < h; y++) {
+            if (fwrite(frame->data[i] + (size_t)y * frame->linesize[i], 1, w, f) != (size_t)w) return AVERROR(EIO);
+        }
+    }
+    return PLAYER_ERR_OK;
+}
+
+/// @brief 缓冲区第一帧的显示时长，按帧的时间戳和时长计算，与 video_refresh_timer 相同
+static int64_t head_frame_duration(PlayerSession* session, int64_t frame_time) {
+    VideoSyncParams params;
+    int64_t pts[VIDEO_SYNC_MAX_FRAMES], duration[VIDEO_SYNC_MAX_FRAMES];
+    memset(&params, 0, sizeof(VideoSyncParams));
+    get_video_sync_frames(session, &params, pts, duration);
+    // 输出为固定帧率，名义帧时长使用输出的帧时长
+    params.frame_time = frame_time;
+    return video_sync_frame_duration(&params, 0);
+}
+
+/// @brief 保证视频缓冲区中至少有两帧（或已到文件尾部）
+static int fill_video_buffer(PlayerSession* session) {
+    char video_writed = 0;
+    int re = PLAYER_ERR_OK;
+    while (av_fifo_can_read(session->video_buffer) < 2 && !session->video_is_eof && av_fifo_can_write(session->video_buffer)) {
+        if ((re = decode(session, NULL, &video_writed))) return re;
+    }
+    return re;
+}
+
+int render_session(PlayerSession* session, FILE* audio_file, FILE* video_file, PlayerRenderResult* result) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    int re = PLAYER_ERR_OK;
+    int64_t start = av_gettime_relative();
+    PlayerRenderResult res;
+    memset(&res, 0, sizeof(PlayerRenderResult));
+    uint8_t* audio_buf = NULL;
+    int period = session->has_audio ? session->sdl_spec.samples : 0;
+    size_t audio_bytes_per_sample = session->has_audio ? (size_t)session->target_format_pbytes * session->sdl_spec.channels : 0;
+    uint64_t audio_data_size = 0;
+    char audio_finished = !session->has_audio, video_finished = !session->has_video;
+    // 虚拟时钟，位置为视频时间轴上的时间
+    int64_t clock = 0;
+    uint64_t slot = 0;
+    AVRational rate = { 25, 1 };
+    int64_t frame_time = 0;
+    AVFrame* scaled = NULL;
+    AVFrame* last_frame = NULL;
+    if (session->has_video) {
+        if (session->video_frame_rate.num && session->video_frame_rate.den) {
+            rate = av_mul_q(session->video_frame_rate, session->speed);
+        }
+        frame_time = av_rescale_q(1, av_inv_q(rate), AV_TIME_BASE_Q);
+        if (!(scaled = av_frame_alloc())) {
+            re = PLAYER_ERR_OOM;
+            goto end;
+        }
+    } else {
+        frame_time = av_rescale(period, AV_TIME_BASE, session->sdl_spec.freq);
+    }
+    if (session->has_audio) {
+        if (!(audio_buf = av_malloc(period * audio_bytes_per_sample))) {
+            re = PLAYER_ERR_OOM;
+            goto end;
+        }
+        if (audio_file && (re = write_wav_header(audio_file, session, 0))) {
+            goto end;
+        }
+    }
+    while (!audio_finished || !video_finished) {
+        if (session->stoping) break;
+        if (!audio_finished) {
+            // 相当于一次音频回调
+            char audio_writed = 0;
+            while (av_audio_fifo_size(session->buffer) < period && !session->audio_is_eof) {
+                if ((re = decode(session, &audio_writed, NULL))) goto end;
+            }
+            int readed = av_audio_fifo_read(session->buffer, (void**)&audio_buf, period);
+            if (readed < 0) {
+                re = readed;
+                goto end;
+            }
+            if (readed == 0) {
+                audio_finished = 1;
+            } else {
+                if (audio_file && fwrite(audio_buf, audio_bytes_per_sample, readed, audio_file) != (size_t)readed) {
+                    re = AVERROR(EIO);
+                    goto end;
+                }
+                audio_data_size += (uint64_t)readed * audio_bytes_per_sample;
+                res.audio_samples += readed;
+                session->pts += av_rescale(readed, AV_TIME_BASE, session->sdl_spec.freq);
+            }
+            int64_t diff = session->first_pts != INT64_MIN && session->video_first_pts != INT64_MIN ? session->first_pts - session->video_first_pts : 0;
+            clock = session->pts - diff;
+        }
+        if (audio_finished) {
+            // 没有音频（或音频已结束）时由视频帧推动时钟
+            clock += frame_time;
+        }
+        while (!video_finished && (int64_t)slot * frame_time <= clock) {
+            int64_t slot_time = (int64_t)slot * frame_time;
+            if ((re = fill_video_buffer(session))) goto end;
+            // 与 video_refresh_timer 相同：丢弃已经过时的帧，最后一帧保留
+            // 可变帧率的视频按每帧的时间戳决定重复或丢弃，输出为固定帧率
+            int64_t head_duration = head_frame_duration(session, frame_time);
+            while (av_fifo_can_read(session->video_buffer) >= 2 && slot_time >= session->video_pts + head_duration) {
+                AVFrame* frame;
+                av_fifo_read(session->video_buffer, &frame, 1);
+                if (frame == last_frame) last_frame = NULL;
+                else res.dropped_frames++;
+                av_frame_free(&frame);
+                session->video_pts += head_duration;
+                if ((re = fill_video_buffer(session))) goto end;
+                head_duration = head_frame_duration(session, frame_time);
+            }
+            if (session->video_is_eof && av_fifo_can_read(session->video_buffer) < 2 && slot_time >= session->video_pts + head_duration) {
+                // 最后一帧已显示完毕
+                video_finished = 1;
+                break;
+            }
+            AVFrame* frame;
+            if (av_fifo_peek(session->video_buffer, &frame, 1, 0) < 0) {
+                video_finished = 1;
+                break;
+            }
+            if (frame == last_frame) res.duplicated_frames++;
+            if (video_file) {
+                session->sws = sws_getCachedContext(session->sws, frame->width, frame->height, frame->format, frame->width, frame->height, AV_PIX_FMT_YUV420P, SWS_BICUBIC, NULL, NULL, NULL);
+                if (!session->sws) {
+                    re = PLAYER_ERR_OOM;
+                    goto end;
+                }
+                av_frame_unref(scaled);
+                if ((re = sws_scale_frame(session->sws, scaled, frame)) < 0) {
+                    goto end;
+                }
+                scaled->sample_aspect_ratio = frame->sample_aspect_ratio;
+                if ((re = write_y4m_frame(video_file, scaled, slot == 0, rate))) {
+                    goto end;
+                }
+            }
+            last_frame = frame;
+            res.video_frames++;
+            slot++;
+        }
+    }
+    re = PLAYER_ERR_OK;
+end:
+    if (audio_file && session->has_audio && audio_buf) {
+        int tmp = write_wav_header(audio_file, session, audio_data_size);
+        if (!re) re = tmp;
+    }
+    res.duration = session->has_video ? (int64_t)slot * frame_time : av_rescale(res.audio_samples, AV_TIME_BASE, session->sdl_spec.freq);
+    res.elapsed = av_gettime_relative() - start;
+    if (result) memcpy(result, &res, sizeof(PlayerRenderResult));
+    av_log(NULL, AV_LOG_VERBOSE, "Rendered %llu audio samples and %llu video frames in %lld us.\n", res.audio_samples, res.video_frames, res.elapsed);
+    if (audio_buf) av_free(audio_buf);
+    av_frame_free(&scaled);
+    return re;
+}
@@ -0,0 +1,19 @@
+#ifndef _PLAYER_RENDER_H
+#define _PLAYER_RENDER_H
+#if __cplusplus
+extern "C" {
+#endif
+#include "core.h"
+/**
+ * @brief 以虚拟时钟尽可能快地处理整个文件
+ * @param session 已打开解码器的会话（不需要音频设备和窗口）
+ * @param audio_file 输出 WAV 的文件，为NULL时不输出
+ * @param video_file 输出 Y4M 的文件，为NULL时不输出
+ * @param result 用于接收结果的指针（可选）
+ * @return 错误代码
+*/
+int render_session(PlayerSession* session, FILE* audio_file, FILE* video_file, PlayerRenderResult* result);
+#if __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,228 @@
+#include "seek_index.h"
+#include "probe_cache.h"
+#include "open.h"
+
+#define SEEK_INDEX_MAGIC MKTAG('P', 'S', 'I', 'X')
+#define SEEK_INDEX_VERSION 1
+
+/// 索引文件头，之后是按时间排序的 SeekIndexEntry，加载时直接映射到内存
+typedef struct SeekIndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    int64_t size;
+    int64_t mtime;
+    int32_t stream_index;
+    int32_t codec_id;
+    int32_t time_base_num;
+    int32_t time_base_den;
+    int64_t start_pts;
+    int64_t end_pts;
+    uint64_t count;
+} SeekIndexHeader;
+
+/// @brief 是否需要建立索引（没有索引或没有时长的可以随机访问的本地文件）
+static int seek_index_needed(PlayerSession* session) {
+    PlayerSettings* s = session->settings;
+    AVFormatContext* fmt = session->fmt;
+    if (!s->seek_index || s->input_format || s->low_latency) return 0;
+    if (!fmt->pb || !(fmt->pb->seekable & AVIO_SEEKABLE_NORMAL)) return 0;
+    if (fmt->duration == AV_NOPTS_VALUE) return 1;
+    for (unsigned int i = 0; i < fmt->nb_streams; i++) {
+        if (avformat_index_get_entries_count(fmt->streams[i]) > 0) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief 映射索引文件并添加到 demuxer 的索引中
+ * @return 成功返回1
+*/
+static int load_index(PlayerSession* session, const char* path, const LocalFileKey* key) {
+    AVFormatContext* fmt = session->fmt;
+    wchar_t* wpath = utf8_to_wide(path);
+    if (!wpath) return 0;
+    HANDLE file = CreateFileW(wpath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    av_free(wpath);
+    if (file == INVALID_HANDLE_VALUE) return 0;
+    HANDLE mapping = NULL;
+    const uint8_t* view = NULL;
+    int ok = 0;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(SeekIndexHeader)) goto end;
+    if (!(mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL))) goto end;
+    if (!(view = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0))) goto end;
+    const SeekIndexHeader* h = (const SeekIndexHeader*)view;
+    if (h->magic != SEEK_INDEX_MAGIC || h->version != SEEK_INDEX_VERSION) goto end;
+    // 文件已被修改
+    if (h->size != key->size || h->mtime != key->mtime) goto end;
+    if (h->count > (uint64_t)(size.QuadPart - sizeof(SeekIndexHeader)) / sizeof(SeekIndexEntry)) goto end;
+    if ((uint64_t)size.QuadPart != sizeof(SeekIndexHeader) + h->count * sizeof(SeekIndexEntry)) goto end;
+    if (h->stream_index < 0 || (unsigned int)h->stream_index >= fmt->nb_streams) goto end;
+    AVStream* st = fmt->streams[h->stream_index];
+    if (st->codecpar->codec_id != (enum AVCodecID)h->codec_id) goto end;
+    if (st->time_base.num != h->time_base_num || st->time_base.den != h->time_base_den) goto end;
+    const SeekIndexEntry* entries = (const SeekIndexEntry*)(view + sizeof(SeekIndexHeader));
+    // 条目已按时间排序，每次都添加在末尾
+    for (uint64_t i = 0; i < h->count; i++) {
+        if (av_add_index_entry(st, entries[i].pos, entries[i].pts, 0, 0, AVINDEX_KEYFRAME) < 0) goto end;
+    }
+    if (h->start_pts != AV_NOPTS_VALUE && h->end_pts != AV_NOPTS_VALUE) {
+        session->seek_index_duration = av_rescale_q(h->end_pts - h->start_pts, st->time_base, AV_TIME_BASE_Q);
+    }
+    av_log(NULL, AV_LOG_VERBOSE, "Loaded %llu keyframes from seek index: %s\n", (unsigned long long)h->count, path);
+    ok = 1;
+end:
+    if (view) UnmapViewOfFile(view);
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+    return ok;
+}
+
+void seek_index_open(PlayerSession* session, const char* url) {
+    if (!session || !url || !session->fmt || !seek_index_needed(session)) return;
+    LocalFileKey key;
+    if (!get_local_file_key(url, &key)) return;
+    char* path = get_cache_file_path(session->settings->seek_index, url, "pidx");
+    if (!path) return;
+    int loaded = load_index(session, path, &key);
+    av_free(path);
+    if (loaded) return;
+    SeekIndexBuilder* b = (SeekIndexBuilder*)av_mallocz(sizeof(SeekIndexBuilder));
+    if (!b) return;
+    b->stream_index = -1;
+    b->start_pts = AV_NOPTS_VALUE;
+    b->end_pts = AV_NOPTS_VALUE;
+    session->seek_index_builder = b;
+}
+
+void seek_index_add_packet(PlayerSession* session, const AVPacket* pkt) {
+    if (!session || !pkt || !session->seek_index_builder) return;
+    SeekIndexBuilder* b = session->seek_index_builder;
+    if (b->stream_index < 0) {
+        // 优先记录视频流
+        AVStream* st = session->has_video ? session->video_input_stream : session->has_audio ? session->audio_input_stream : NULL;
+        if (!st) return;
+        b->stream_index = st->index;
+    }
+    if (pkt->stream_index != b->stream_index) return;
+    int64_t pts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+    if (pts == AV_NOPTS_VALUE) return;
+    if (b->start_pts == AV_NOPTS_VALUE || pts < b->start_pts) b->start_pts = pts;
+    int64_t end = pts + FFMAX(pkt->duration, 0);
+    if (b->end_pts == AV_NOPTS_VALUE || end > b->end_pts) b->end_pts = end;
+    if (!(pkt->flags & AV_PKT_FLAG_KEY) || pkt->pos < 0) return;
+    if (b->count && pts <= b->entries[b->count - 1].pts) return;
+    if (b->count == b->capacity) {
+        unsigned int capacity = b->capacity ? b->capacity * 2 : 256;
+        SeekIndexEntry* entries = (SeekIndexEntry*)av_realloc_array(b->entries, capacity, sizeof(SeekIndexEntry));
+        if (!entries) {
+            av_log(NULL, AV_LOG_WARNING, "Failed to allocate memory for seek index.\n");
+            seek_index_free(&session->seek_index_builder);
+            return;
+        }
+        b->entries = entries;
+        b->capacity = capacity;
+    }
+    b->entries[b->count].pts = pts;
+    b->entries[b->count].pos = pkt->pos;
+    b->count++;
+}
+
+static void write_index(PlayerSession* session, SeekIndexBuilder* b) {
+    const char* url = session->fmt->url;
+    LocalFileKey key;
+    if (!url || !get_local_file_key(url, &key)) return;
+    char* path = get_cache_file_path(session->settings->seek_index, url, "pidx");
+    char* tmp = path ? av_asprintf("%s.tmp", path) : NULL;
+    AVIOContext* pb = NULL;
+    if (!tmp || avio_open2(&pb, tmp, AVIO_FLAG_WRITE, NULL, NULL) < 0) {
+        av_log(NULL, AV_LOG_WARNING, "Failed to write seek index: %s\n", path ? path : url);
+        goto end;
+    }
+    AVStream* st = session->fmt->streams[b->stream_index];
+    SeekIndexHeader h;
+    memset(&h, 0, sizeof(SeekIndexHeader));
+    h.magic = SEEK_INDEX_MAGIC;
+    h.version = SEEK_INDEX_VERSION;
+    h.size = key.size;
+    h.mtime = key.mtime;
+    h.stream_index = b->stream_index;
+    h.codec_id = st->codecpar->codec_id;
+    h.time_base_num = st->time_base.num;
+    h.time_base_den = st->time_base.den;
+    h.start_pts = b->start_pts;
+    h.end_pts = b->end_pts;
+    h.count = b->count;
+    avio_write(pb, (const unsigned char*)&h, sizeof(SeekIndexHeader));
+    avio_write(pb, (const unsigned char*)b->entries, (int)(b->count * sizeof(SeekIndexEntry)));
+    int error = pb->error;
+    avio_closep(&pb);
+    if (error < 0 || !replace_cache_file(tmp, path)) {
+        av_log(NULL, AV_LOG_WARNING, "Failed to write seek index: %s\n", path);
+        goto end;
+    }
+    av_log(NULL, AV_LOG_VERBOSE, "Wrote %u keyframes to seek index: %s\n", b->count, path);
+end:
+    av_free(tmp);
+    av_free(path);
+}
+
+void seek_index_finish(PlayerSession* session) {
+    if (!session || !session->seek_index_builder) return;
+    SeekIndexBuilder* b = session->seek_index_builder;
+    if (b->stream_index >= 0 && b->count) {
+        write_index(session, b);
+        if (b->start_pts != AV_NOPTS_VALUE && b->end_pts != AV_NOPTS_VALUE) {
+            session->seek_index_duration = av_rescale_q(b->end_pts - b->start_pts, session->fmt->streams[b->stream_index]->time_base, AV_TIME_BASE_Q);
+        }
+    }
+    seek_index_free(&session->seek_index_builder);
+}
+
+void seek_index_free(SeekIndexBuilder** builder) {
+    if (!builder || !*builder) return;
+    av_free((*builder)->entries);
+    av_freep(builder);
+}
+
+int build_seek_index(const char* url, PlayerSettings* settings) {
+    if (!url || !settings) return PLAYER_ERR_NULLPTR;
+    PlayerSession* session = (PlayerSession*)malloc(sizeof(PlayerSession));
+    AVPacket* pkt = NULL;
+    int re = PLAYER_ERR_OK;
+    if (!session) return PLAYER_ERR_OOM;
+    memset(session, 0, sizeof(PlayerSession));
+    session->settings = settings;
+    if ((re = open_input(session, url))) {
+        goto end;
+    }
+    // 已有索引文件或不需要索引
+    if (!session->seek_index_builder) goto end;
+    if (!find_video_stream(session)) {
+        session->has_video = 1;
+    } else if (!(re = find_audio_stream(session))) {
+        session->has_audio = 1;
+    } else {
+        goto end;
+    }
+    discard_unused_streams(session);
+    if (!(pkt = av_packet_alloc())) {
+        re = PLAYER_ERR_OOM;
+        goto end;
+    }
+    while ((re = av_read_frame(session->fmt, pkt)) >= 0) {
+        seek_index_add_packet(session, pkt);
+        av_packet_unref(pkt);
+        if (!session->seek_index_builder) {
+            re = PLAYER_ERR_OOM;
+            goto end;
+        }
+    }
+    if (re != AVERROR_EOF) goto end;
+    re = PLAYER_ERR_OK;
+    seek_index_finish(session);
+end:
+    av_packet_free(&pkt);
+    player_free(&session);
+    return re;
+}
@@ -0,0 +1,42 @@
+#ifndef _PLAYER_SEEK_INDEX_H
+#define _PLAYER_SEEK_INDEX_H
+#if __cplusplus
+extern "C" {
+#endif
+#include "core.h"
+
+typedef struct SeekIndexEntry {
+    /// @brief 关键帧的时间（流的时间基）
+    int64_t pts;
+    /// @brief 关键帧数据包在文件中的位置
+    int64_t pos;
+} SeekIndexEntry;
+
+typedef struct SeekIndexBuilder {
+    SeekIndexEntry* entries;
+    unsigned int count;
+    unsigned int capacity;
+    /// @brief 记录的流序号，<0 时在读到第一个数据包时选择
+    int stream_index;
+    /// @brief 流中最早的时间和最晚的结束时间
+    int64_t start_pts;
+    int64_t end_pts;
+} SeekIndexBuilder;
+
+/**
+ * @brief 加载索引文件并添加到 demuxer 的索引中
+ *
+ * 只对没有索引或没有时长的本地文件使用。没有索引文件时开始记录，读到文件尾时写入。
+*/
+void seek_index_open(PlayerSession* session, const char* url);
+/// @brief 记录数据包，只记录选择的流的关键帧
+void seek_index_add_packet(PlayerSession* session, const AVPacket* pkt);
+/// @brief 文件已读完，写入索引文件并停止记录
+void seek_index_finish(PlayerSession* session);
+void seek_index_free(SeekIndexBuilder** builder);
+/// @brief 扫描整个文件建立索引（会阻塞当前线程）
+int build_seek_index(const char* url, PlayerSettings* settings);
+#if __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,56 @@
+#include "sync.h"
+#include <string.h>
+
+int64_t video_sync_next_vsync(int64_t now, int64_t last_vsync, int64_t vsync_time) {
+    if (last_vsync == INT64_MIN || now <= last_vsync || vsync_time <= 0) return now;
+    int64_t n = (now - last_vsync + vsync_time - 1) / vsync_time;
+    return last_vsync + n * vsync_time;
+}
+
+int64_t video_sync_frame_duration(const VideoSyncParams* p, int index) {
+    if (!p) return 0;
+    if (p->frame_pts && index + 1 < p->frame_pts_count) {
+        int64_t pts = p->frame_pts[index], next = p->frame_pts[index + 1];
+        if (pts != INT64_MIN && next != INT64_MIN && next > pts) return next - pts;
+    }
+    if (p->frame_duration && index < p->frame_pts_count && p->frame_duration[index] > 0) return p->frame_duration[index];
+    return p->frame_time;
+}
+
+void video_sync_decide(const VideoSyncParams* p, VideoSyncDecision* d) {
+    if (!p || !d) return;
+    memset(d, 0, sizeof(VideoSyncDecision));
+    unsigned char head_displayed = p->head_displayed;
+    int64_t half = p->vsync_time / 2;
+    d->video_pts = p->video_pts;
+    // 这次显示的画面会在下一次垂直同步时出现，按那时的播放位置选择帧
+    d->next_vsync = video_sync_next_vsync(p->now, p->last_vsync, p->vsync_time);
+    d->display_pos = p->clock + (d->next_vsync - p->now);
+    int64_t next_frame_time = d->video_pts + video_sync_frame_duration(p, 0);
+    // 每帧显示在离其时间戳最近的垂直同步上，23.976 fps 在 60 Hz 下即为 3:2 交替
+    while (d->display_pos + half >= next_frame_time) {
+        int remain = p->frames - d->advance;
+        // 没有下一帧时保留当前帧，解码结束时才取出最后一帧
+        if (remain <= 0 || (remain == 1 && !p->eof)) {
+            d->underflow = 1;
+            d->delay = p->vsync_time;
+            return;
+        }
+        if (!head_displayed) d->dropped++;
+        head_displayed = 0;
+        d->advance++;
+        d->video_pts = next_frame_time;
+        next_frame_time = d->video_pts + video_sync_frame_duration(p, d->advance);
+    }
+    // 下一帧应出现在离其时间戳最近的垂直同步上，提前半个周期唤醒以赶上这次垂直同步
+    int64_t vsyncs = p->vsync_time > 0 ? (next_frame_time - d->display_pos + half) / p->vsync_time : 1;
+    if (vsyncs < 1) vsyncs = 1;
+    d->delay = d->next_vsync + vsyncs * p->vsync_time - half - p->now;
+    if (d->delay < 0) d->delay = 0;
+}
+
+int64_t video_sync_audio_clock(int64_t pts, int64_t av_diff, int64_t last_pts_timestamp, int64_t now, int64_t device_latency) {
+    int64_t ad = last_pts_timestamp != INT64_MIN ? now - last_pts_timestamp : 0;
+    // 交给设备的数据要等设备缓冲区播放完才能听到
+    return pts - av_diff + ad - device_latency;
+}
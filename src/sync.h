@@ -0,0 +1,86 @@
+#ifndef _PLAYER_SYNC_H
+#define _PLAYER_SYNC_H
+#if __cplusplus
+extern "C" {
+#endif
+/**
+ * 音视频同步的判断逻辑，不依赖 SDL、FFmpeg 和系统时钟，所有时间由调用者传入（单位：微秒），
+ * 可以用虚拟时钟单独测试。
+*/
+#include <stdint.h>
+/// 一次判断最多参考的缓冲帧数
+#define VIDEO_SYNC_MAX_FRAMES 16
+
+typedef struct VideoSyncParams {
+    /// @brief 当前播放位置（主时钟，相对于视频第一帧）
+    int64_t clock;
+    /// @brief 当前系统时间
+    int64_t now;
+    /// @brief 上一次垂直同步的时间，INT64_MIN 表示未知或未开启垂直同步
+    int64_t last_vsync;
+    /// @brief 垂直同步（显示器刷新）周期
+    int64_t vsync_time;
+    /// @brief 缓冲区第一帧的时间
+    int64_t video_pts;
+    /// @brief 名义帧时长（已按播放速度换算），帧没有时间戳和时长时使用
+    int64_t frame_time;
+    /// @brief 缓冲区中的帧数
+    int frames;
+    /// @brief 缓冲区中前 frame_pts_count 帧的时间（只用于计算帧之间的间隔），INT64_MIN 表示未知（可为NULL）
+    const int64_t* frame_pts;
+    /// @brief 缓冲区中前 frame_pts_count 帧的时长，<=0 表示未知（可为NULL）
+    const int64_t* frame_duration;
+    int frame_pts_count;
+    /// @brief 解码已结束，最后一帧可以取出
+    unsigned char eof : 1;
+    /// @brief 缓冲区第一帧已经显示过
+    unsigned char head_displayed : 1;
+} VideoSyncParams;
+
+typedef struct VideoSyncDecision {
+    /// @brief 需要从缓冲区取出的帧数
+    int advance;
+    /// @brief 取出的帧中未显示过（即被丢弃）的帧数
+    int dropped;
+    /// @brief 取出后缓冲区第一帧的时间
+    int64_t video_pts;
+    /// @brief 这次显示的画面出现的时间（下一次垂直同步）
+    int64_t next_vsync;
+    /// @brief 画面出现时的播放位置
+    int64_t display_pos;
+    /// @brief 距下一次刷新的时间
+    int64_t delay;
+    /// @brief 缓冲区中没有下一帧，这次不显示，等待解码
+    unsigned char underflow : 1;
+} VideoSyncDecision;
+
+/**
+ * @brief 计算下一次垂直同步的时间
+ * @param last_vsync 上一次垂直同步的时间，INT64_MIN 时返回 now
+*/
+int64_t video_sync_next_vsync(int64_t now, int64_t last_vsync, int64_t vsync_time);
+/**
+ * @brief 缓冲区第 index 帧的显示时长
+ *
+ * 优先使用到下一帧时间戳的间隔，其次是帧自身的时长，都未知时才使用名义帧时长，
+ * 因此可变帧率和解码器跳帧后的时间不连续都能正确处理。
+*/
+int64_t video_sync_frame_duration(const VideoSyncParams* params, int index);
+/**
+ * @brief 决定这次刷新取出哪些帧、何时再次刷新
+ *
+ * 每帧显示在离其时间戳最近的垂直同步上，落后的帧被丢弃。
+*/
+void video_sync_decide(const VideoSyncParams* params, VideoSyncDecision* decision);
+/**
+ * @brief 根据音频回调记录的位置计算音频时钟
+ * @param pts 最近一次交给音频设备的数据的结束位置
+ * @param av_diff 音频第一帧与视频第一帧的时间差
+ * @param last_pts_timestamp 最近一次音频回调的时间，INT64_MIN 表示还没有回调
+ * @param device_latency 音频设备缓冲区的延迟
+*/
+int64_t video_sync_audio_clock(int64_t pts, int64_t av_diff, int64_t last_pts_timestamp, int64_t now, int64_t device_latency);
+#if __cplusplus
+}
+#endif
+#endif
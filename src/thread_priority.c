@@ -0,0 +1,94 @@
+#include "thread_priority.h"
+
+typedef HANDLE (WINAPI* AvSetMmThreadCharacteristicsWFunc)(LPCWSTR task_name, LPDWORD task_index);
+typedef BOOL (WINAPI* AvRevertMmThreadCharacteristicsFunc)(HANDLE avrt_handle);
+
+static INIT_ONCE avrt_once = INIT_ONCE_STATIC_INIT;
+static AvSetMmThreadCharacteristicsWFunc set_mm_thread_characteristics = NULL;
+static AvRevertMmThreadCharacteristicsFunc revert_mm_thread_characteristics = NULL;
+
+/// @brief 动态加载 avrt.dll，系统中没有时不使用 MMCSS
+static BOOL CALLBACK load_avrt(PINIT_ONCE once, PVOID param, PVOID* context) {
+    HMODULE avrt = LoadLibraryW(L"avrt.dll");
+    if (avrt) {
+        set_mm_thread_characteristics = (AvSetMmThreadCharacteristicsWFunc)GetProcAddress(avrt, "AvSetMmThreadCharacteristicsW");
+        revert_mm_thread_characteristics = (AvRevertMmThreadCharacteristicsFunc)GetProcAddress(avrt, "AvRevertMmThreadCharacteristics");
+    }
+    return TRUE;
+}
+
+static const char* thread_name(int thread) {
+    switch (thread) {
+        case PLAYER_THREAD_DECODE:
+            return "decode";
+        case PLAYER_THREAD_EVENT:
+            return "event";
+        default:
+            return "unknown";
+    }
+}
+
+void apply_thread_settings(PlayerSession* session, int thread) {
+    if (!session || thread < 0 || thread >= PLAYER_THREAD_COUNT) return;
+    PlayerSettings* s = session->settings;
+    PlayerThreadInfo* info = &session->thread_info[thread];
+    HANDLE self = GetCurrentThread();
+    memset(info, 0, sizeof(PlayerThreadInfo));
+    info->requested_priority = s->thread_priority[thread];
+    info->requested_affinity = s->thread_affinity[thread];
+    info->numa_node = -1;
+    if (info->requested_priority >= PLAYER_THREAD_PRIORITY_REALTIME) {
+        InitOnceExecuteOnce(&avrt_once, load_avrt, NULL, NULL);
+        DWORD task_index = 0;
+        if (set_mm_thread_characteristics && revert_mm_thread_characteristics && (session->mmcss_handles[thread] = set_mm_thread_characteristics(L"Playback", &task_index))) {
+            info->applied_priority = PLAYER_THREAD_PRIORITY_REALTIME;
+        } else {
+            // MMCSS 服务不可用时退回到提高线程优先级
+            info->error = set_mm_thread_characteristics ? GetLastError() : ERROR_PROC_NOT_FOUND;
+            av_log(NULL, AV_LOG_WARNING, "Failed to register %s thread with MMCSS (%lu), falling back to high priority.\n", thread_name(thread), info->error);
+        }
+    }
+    if (info->requested_priority >= PLAYER_THREAD_PRIORITY_HIGH && info->applied_priority != PLAYER_THREAD_PRIORITY_REALTIME) {
+        if (SetThreadPriority(self, THREAD_PRIORITY_HIGHEST)) {
+            info->applied_priority = PLAYER_THREAD_PRIORITY_HIGH;
+        } else {
+            info->error = GetLastError();
+            av_log(NULL, AV_LOG_WARNING, "Failed to raise %s thread priority (%lu).\n", thread_name(thread), info->error);
+        }
+    }
+    if (s->thread_numa_node[thread] >= 0) {
+        GROUP_AFFINITY affinity;
+        memset(&affinity, 0, sizeof(GROUP_AFFINITY));
+        if (GetNumaNodeProcessorMaskEx((USHORT)s->thread_numa_node[thread], &affinity)) {
+            // 同时指定了亲和性时取交集
+            if (info->requested_affinity) affinity.Mask &= (KAFFINITY)info->requested_affinity;
+            if (affinity.Mask && SetThreadGroupAffinity(self, &affinity, NULL)) {
+                info->applied_affinity = affinity.Mask;
+                info->processor_group = affinity.Group;
+                info->numa_node = s->thread_numa_node[thread];
+            } else {
+                info->error = affinity.Mask ? GetLastError() : ERROR_INVALID_PARAMETER;
+            }
+        } else {
+            info->error = GetLastError();
+        }
+        if (info->numa_node < 0) av_log(NULL, AV_LOG_WARNING, "Failed to bind %s thread to NUMA node %d (%lu).\n", thread_name(thread), s->thread_numa_node[thread], info->error);
+    } else if (info->requested_affinity) {
+        if (SetThreadAffinityMask(self, (DWORD_PTR)info->requested_affinity)) {
+            info->applied_affinity = (DWORD_PTR)info->requested_affinity;
+        } else {
+            info->error = GetLastError();
+            av_log(NULL, AV_LOG_WARNING, "Failed to set %s thread affinity to 0x%llx (%lu).\n", thread_name(thread), (unsigned long long)info->requested_affinity, info->error);
+        }
+    }
+    info->os_priority = GetThreadPriority(self);
+    av_log(NULL, AV_LOG_VERBOSE, "%s thread: priority %d (requested %d, system %d), affinity 0x%llx, NUMA node %d.\n", thread_name(thread), info->applied_priority, info->requested_priority, info->os_priority, (unsigned long long)info->applied_affinity, info->numa_node);
+}
+
+void revert_thread_settings(PlayerSession* session, int thread) {
+    if (!session || thread < 0 || thread >= PLAYER_THREAD_COUNT) return;
+    if (session->mmcss_handles[thread]) {
+        revert_mm_thread_characteristics(session->mmcss_handles[thread]);
+        session->mmcss_handles[thread] = NULL;
+    }
+}
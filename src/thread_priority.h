@@ -0,0 +1,19 @@
+#ifndef _PLAYER_THREAD_PRIORITY_H
+#define _PLAYER_THREAD_PRIORITY_H
+#if __cplusplus
+extern "C" {
+#endif
+#include "core.h"
+/**
+ * @brief 按设置调整当前线程的优先级和 CPU 亲和性，结果记录在 thread_info 中
+ *
+ * 需要在线程内部调用（MMCSS 只能注册调用者所在的线程）。无法应用的设置会降级处理，不会返回错误。
+ * @param thread PLAYER_THREAD_*
+*/
+void apply_thread_settings(PlayerSession* session, int thread);
+/// @brief 线程退出前调用，取消 MMCSS 注册
+void revert_thread_settings(PlayerSession* session, int thread);
+#if __cplusplus
+}
+#endif
+#endif
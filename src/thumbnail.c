@@ -0,0 +1,207 @@
+#include "thumbnail.h"
+#include "open.h"
+#include "decode.h"
+#include "libavutil/cpu.h"
+
+typedef struct ThumbnailBatch {
+    const char** urls;
+    int url_count;
+    int count;
+    int width;
+    int height;
+    PlayerThumbnailCallback callback;
+    void* userdata;
+    /// @brief 下一个要处理的文件序号
+    volatile LONG next;
+    /// @brief 第一个错误
+    volatile LONG err;
+} ThumbnailBatch;
+
+/// @brief 读取数据包直到解码出一个关键帧
+static int decode_keyframe(PlayerSession* session, AVPacket* pkt, AVFrame* frame) {
+    int re = 0;
+    for (int i = 0; i < THUMBNAIL_MAX_PACKETS; i++) {
+        if ((re = av_read_frame(session->fmt, pkt)) < 0) {
+            break;
+        }
+        if (pkt->stream_index != session->video_input_stream->index || !(pkt->flags & AV_PKT_FLAG_KEY)) {
+            av_packet_unref(pkt);
+            continue;
+        }
+        re = avcodec_send_packet(session->video_decoder, pkt);
+        av_packet_unref(pkt);
+        if (re < 0) return re;
+        if ((re = avcodec_receive_frame(session->video_decoder, frame)) != AVERROR(EAGAIN)) {
+            return re;
+        }
+    }
+    if (re < 0 && re != AVERROR_EOF) return re;
+    // 解码器有延迟时需要冲洗才能取出帧
+    if ((re = avcodec_send_packet(session->video_decoder, NULL)) < 0) return re;
+    return avcodec_receive_frame(session->video_decoder, frame);
+}
+
+/// @brief 按原始图像的宽高比补全未指定的缩略图尺寸（src_width 和 src_height 需大于 0）
+static void get_thumbnail_size(int src_width, int src_height, int* width, int* height) {
+    if (*width <= 0 && *height <= 0) {
+        *width = src_width;
+        *height = src_height;
+    } else if (*width <= 0) {
+        *width = FFMAX((int)av_rescale(*height, src_width, src_height), 1);
+    } else if (*height <= 0) {
+        *height = FFMAX((int)av_rescale(*width, src_height, src_width), 1);
+    }
+}
+
+int extract_thumbnails(const char* url, int count, int width, int height, PlayerThumbnailCallback callback, void* userdata) {
+    if (!url || !callback) return PLAYER_ERR_NULLPTR;
+    if (count <= 0) return PLAYER_ERR_OK;
+    PlayerSession* session = (PlayerSession*)malloc(sizeof(PlayerSession));
+    AVPacket* pkt = NULL;
+    AVFrame* frame = NULL;
+    AVFrame* scaled = NULL;
+    int re = PLAYER_ERR_OK;
+    if (!session) return PLAYER_ERR_OOM;
+    memset(session, 0, sizeof(PlayerSession));
+    if (!(session->settings = player_settings_init())) {
+        free(session);
+        return PLAYER_ERR_OOM;
+    }
+    session->settings_is_alloc = 1;
+    if ((re = open_input(session, url))) {
+        goto end;
+    }
+    if ((re = find_video_stream(session)) == PLAYER_ERR_NO_STREAM_OR_DECODER) {
+        // 音乐文件使用封面作为缩略图
+        re = find_cover_stream(session, &session->video_input_stream);
+    }
+    if (re) {
+        goto end;
+    }
+    session->has_video = 1;
+    // 只需要视频流，其他流在 demux 时直接丢弃
+    discard_unused_streams(session);
+    AVCodecParameters* par = session->video_input_stream->codecpar;
+    // 尽量用 lowres 直接解码出较小的图像；流信息中没有尺寸时不知道原始大小，不使用 lowres
+    if (par->width > 0 && par->height > 0) {
+        int w = width, h = height;
+        get_thumbnail_size(par->width, par->height, &w, &h);
+        while ((par->width >> (session->video_lowres + 1)) >= w && (par->height >> (session->video_lowres + 1)) >= h && session->video_lowres < 3) {
+            session->video_lowres++;
+        }
+    }
+    session->keyframes_only = 1;
+    if ((re = open_video_decoder(session))) {
+        goto end;
+    }
+    pkt = av_packet_alloc();
+    frame = av_frame_alloc();
+    scaled = av_frame_alloc();
+    if (!pkt || !frame || !scaled) {
+        re = PLAYER_ERR_OOM;
+        goto end;
+    }
+    AVRational tb = session->video_input_stream->time_base;
+    int64_t start = session->video_input_stream->start_time != AV_NOPTS_VALUE ? av_rescale_q(session->video_input_stream->start_time, tb, AV_TIME_BASE_Q) : 0;
+    int64_t duration = session->fmt->duration;
+    if (duration == AV_NOPTS_VALUE && session->video_input_stream->duration != AV_NOPTS_VALUE) {
+        duration = av_rescale_q(session->video_input_stream->duration, tb, AV_TIME_BASE_Q);
+    }
+    for (int i = 0; i < count; i++) {
+        if (duration != AV_NOPTS_VALUE && duration > 0) {
+            // 取每一段的中间位置，没有时长时依次取关键帧
+            int64_t ts = start + duration * (2 * i + 1) / (2 * count);
+            if ((re = av_seek_frame(session->fmt, session->video_input_stream->index, av_rescale_q(ts, AV_TIME_BASE_Q, tb), AVSEEK_FLAG_BACKWARD)) < 0) {
+                av_log(NULL, AV_LOG_WARNING, "Failed to seek to %s: %s (%i)\n", av_ts2timestr(ts, &AV_TIME_BASE_Q), av_err2str(re), re);
+            }
+            avcodec_flush_buffers(session->video_decoder);
+        }
+        if ((re = decode_keyframe(session, pkt, frame)) < 0) {
+            if (re == AVERROR_EOF) re = PLAYER_ERR_OK;
+            break;
+        }
+        if (duration == AV_NOPTS_VALUE || duration <= 0) {
+            // 冲洗后需要重置解码器才能继续解码
+            avcodec_flush_buffers(session->video_decoder);
+        }
+        // 以解码出的图像尺寸为准，流信息中的尺寸可能为 0
+        if (frame->width <= 0 || frame->height <= 0) {
+            re = AVERROR_INVALIDDATA;
+            break;
+        }
+        int w = width, h = height;
+        get_thumbnail_size(frame->width, frame->height, &w, &h);
+        session->sws = sws_getCachedContext(session->sws, frame->width, frame->height, frame->format, w, h, AV_PIX_FMT_RGBA, SWS_FAST_BILINEAR, NULL, NULL, NULL);
+        if (!session->sws) {
+            re = PLAYER_ERR_OOM;
+            break;
+        }
+        av_frame_unref(scaled);
+        if ((re = sws_scale_frame(session->sws, scaled, frame)) < 0) {
+            break;
+        }
+        int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? av_rescale_q(frame->best_effort_timestamp, tb, AV_TIME_BASE_Q) - start : INT64_MIN;
+        av_frame_unref(frame);
+        re = PLAYER_ERR_OK;
+        if (callback(userdata, url, i, pts, scaled->data[0], scaled->linesize[0], w, h)) {
+            break;
+        }
+    }
+end:
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    av_frame_free(&scaled);
+    player_free(&session);
+    return re;
+}
+
+static DWORD WINAPI thumbnail_worker(LPVOID handle) {
+    ThumbnailBatch* batch = (ThumbnailBatch*)handle;
+    LONG index;
+    while ((index = InterlockedIncrement(&batch->next) - 1) < batch->url_count) {
+        int re = extract_thumbnails(batch->urls[index], batch->count, batch->width, batch->height, batch->callback, batch->userdata);
+        if (re) {
+            av_log(NULL, AV_LOG_WARNING, "Failed to extract thumbnails from \"%s\".\n", batch->urls[index]);
+            InterlockedCompareExchange(&batch->err, re, 0);
+        }
+    }
+    return 0;
+}
+
+int extract_thumbnails_batch(const char** urls, int url_count, int count, int width, int height, PlayerThumbnailCallback callback, void* userdata, int threads) {
+    if (!urls || !callback) return PLAYER_ERR_NULLPTR;
+    if (url_count <= 0) return PLAYER_ERR_OK;
+    ThumbnailBatch batch;
+    HANDLE* handles = NULL;
+    int created = 0;
+    batch.urls = urls;
+    batch.url_count = url_count;
+    batch.count = count;
+    batch.width = width;
+    batch.height = height;
+    batch.callback = callback;
+    batch.userdata = userdata;
+    batch.next = 0;
+    batch.err = 0;
+    if (threads <= 0) threads = av_cpu_count();
+    threads = FFMIN(FFMIN(threads, url_count), MAXIMUM_WAIT_OBJECTS);
+    if (!(handles = malloc(sizeof(HANDLE) * threads))) {
+        return PLAYER_ERR_OOM;
+    }
+    for (int i = 0; i < threads; i++) {
+        if (!(handles[i] = CreateThread(NULL, 0, thumbnail_worker, &batch, 0, NULL))) {
+            break;
+        }
+        created++;
+    }
+    if (!created) {
+        free(handles);
+        return PLAYER_ERR_FAILED_CREATE_THREAD;
+    }
+    WaitForMultipleObjects(created, handles, TRUE, INFINITE);
+    for (int i = 0; i < created; i++) {
+        CloseHandle(handles[i]);
+    }
+    free(handles);
+    return batch.err;
+}
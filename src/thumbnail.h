@@ -0,0 +1,14 @@
+#ifndef _PLAYER_THUMBNAIL_H
+#define _PLAYER_THUMBNAIL_H
+#if __cplusplus
+extern "C" {
+#endif
+#include "core.h"
+/// 每张缩略图最多读取的数据包数量，防止没有关键帧时扫描整个文件
+#define THUMBNAIL_MAX_PACKETS 2000
+int extract_thumbnails(const char* url, int count, int width, int height, PlayerThumbnailCallback callback, void* userdata);
+int extract_thumbnails_batch(const char** urls, int url_count, int count, int width, int height, PlayerThumbnailCallback callback, void* userdata, int threads);
+#if __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,142 @@
+#include "trace.h"
+
+/// 最多记录名称的线程数
+#define TRACE_MAX_THREAD_NAMES 256
+
+typedef struct TraceEvent {
+    const char* name;
+    int64_t start;
+    int64_t pts;
+    uint32_t duration;
+    DWORD tid;
+} TraceEvent;
+
+typedef struct TraceBuffer {
+    struct TraceBuffer* next;
+    /// @brief 已写入的事件总数，只由所属线程写入
+    volatile LONG64 written;
+    /// @brief 本次记录开始时的 written，之前的事件不导出
+    volatile LONG64 start_index;
+    /// @brief 是否有线程正在使用，线程退出后可以给新的线程使用
+    volatile LONG in_use;
+    TraceEvent events[TRACE_BUFFER_SIZE];
+} TraceBuffer;
+
+typedef struct TraceThreadName {
+    DWORD tid;
+    const char* name;
+} TraceThreadName;
+
+volatile LONG trace_enabled = 0;
+static TraceBuffer* volatile trace_buffers = NULL;
+static int64_t trace_start_time = 0;
+static INIT_ONCE trace_once = INIT_ONCE_STATIC_INIT;
+static DWORD trace_fls_index = FLS_OUT_OF_INDEXES;
+static TraceThreadName trace_thread_names[TRACE_MAX_THREAD_NAMES];
+static volatile LONG trace_thread_name_count = 0;
+
+/// @brief 线程退出时释放缓冲区，已记录的事件保留到被新线程覆盖
+static void WINAPI release_buffer(PVOID data) {
+    TraceBuffer* b = (TraceBuffer*)data;
+    if (b) InterlockedExchange(&b->in_use, 0);
+}
+
+static BOOL CALLBACK init_trace(PINIT_ONCE once, PVOID param, PVOID* context) {
+    trace_fls_index = FlsAlloc(release_buffer);
+    return TRUE;
+}
+
+static TraceBuffer* get_buffer(void) {
+    InitOnceExecuteOnce(&trace_once, init_trace, NULL, NULL);
+    if (trace_fls_index == FLS_OUT_OF_INDEXES) return NULL;
+    TraceBuffer* b = (TraceBuffer*)FlsGetValue(trace_fls_index);
+    if (b) return b;
+    for (b = trace_buffers; b; b = b->next) {
+        if (!InterlockedCompareExchange(&b->in_use, 1, 0)) break;
+    }
+    if (!b) {
+        if (!(b = (TraceBuffer*)av_mallocz(sizeof(TraceBuffer)))) return NULL;
+        b->in_use = 1;
+        TraceBuffer* head;
+        do {
+            head = trace_buffers;
+            b->next = head;
+        } while (InterlockedCompareExchangePointer((PVOID volatile*)&trace_buffers, b, head) != head);
+    }
+    FlsSetValue(trace_fls_index, b);
+    return b;
+}
+
+void trace_record(const char* name, int64_t start, int64_t pts) {
+    int64_t end = av_gettime_relative();
+    TraceBuffer* b = get_buffer();
+    if (!b) return;
+    LONG64 n = b->written;
+    TraceEvent* e = &b->events[n % TRACE_BUFFER_SIZE];
+    e->name = name;
+    e->start = start;
+    e->pts = pts;
+    e->duration = (uint32_t)FFMIN(FFMAX(end - start, 0), UINT32_MAX);
+    e->tid = GetCurrentThreadId();
+    // 事件写完后再增加计数
+    InterlockedExchange64(&b->written, n + 1);
+}
+
+int64_t trace_ts(int64_t pts, AVRational time_base) {
+    if (pts == AV_NOPTS_VALUE) return AV_NOPTS_VALUE;
+    return av_rescale_q(pts, time_base, AV_TIME_BASE_Q);
+}
+
+void trace_set_thread_name(const char* name) {
+    LONG index = InterlockedIncrement(&trace_thread_name_count) - 1;
+    if (index >= TRACE_MAX_THREAD_NAMES) return;
+    trace_thread_names[index].tid = GetCurrentThreadId();
+    trace_thread_names[index].name = name;
+}
+
+void trace_start(void) {
+    for (TraceBuffer* b = trace_buffers; b; b = b->next) {
+        InterlockedExchange64(&b->start_index, b->written);
+    }
+    trace_start_time = av_gettime_relative();
+    InterlockedExchange(&trace_enabled, 1);
+}
+
+void trace_stop(void) {
+    InterlockedExchange(&trace_enabled, 0);
+}
+
+int trace_dump(const char* path) {
+    if (!path) return PLAYER_ERR_NULLPTR;
+    AVIOContext* pb = NULL;
+    int re = avio_open2(&pb, path, AVIO_FLAG_WRITE, NULL, NULL);
+    if (re < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to open \"%s\": %s (%i)\n", path, av_err2str(re), re);
+        return re;
+    }
+    DWORD pid = GetCurrentProcessId();
+    int first = 1;
+    avio_printf(pb, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    LONG names = FFMIN(trace_thread_name_count, TRACE_MAX_THREAD_NAMES);
+    for (LONG i = 0; i < names; i++) {
+        if (!trace_thread_names[i].name) continue;
+        avio_printf(pb, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}", first ? "" : ",", pid, trace_thread_names[i].tid, trace_thread_names[i].name);
+        first = 0;
+    }
+    for (TraceBuffer* b = trace_buffers; b; b = b->next) {
+        LONG64 written = b->written;
+        LONG64 start = FFMAX(b->start_index, written - TRACE_BUFFER_SIZE);
+        for (LONG64 n = start; n < written; n++) {
+            const TraceEvent* e = &b->events[n % TRACE_BUFFER_SIZE];
+            if (e->start < trace_start_time) continue;
+            avio_printf(pb, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%lu,\"tid\":%lu,\"ts\":%lld,\"dur\":%u", first ? "" : ",", e->name, pid, e->tid, (long long)(e->start - trace_start_time), e->duration);
+            if (e->pts != AV_NOPTS_VALUE) avio_printf(pb, ",\"args\":{\"pts\":%lld}", (long long)e->pts);
+            avio_printf(pb, "}");
+            first = 0;
+        }
+    }
+    avio_printf(pb, "\n]}\n");
+    re = pb->error;
+    avio_closep(&pb);
+    return re < 0 ? re : PLAYER_ERR_OK;
+}
@@ -0,0 +1,37 @@
+#ifndef _PLAYER_TRACE_H
+#define _PLAYER_TRACE_H
+#if __cplusplus
+extern "C" {
+#endif
+#include "core.h"
+/**
+ * 记录各处理步骤的耗时，导出为 Chrome / Perfetto 的 trace event JSON。
+ * 每个线程写入自己的缓冲区，不需要加锁；未开启时只有一次判断的开销。
+*/
+/// 每个线程缓冲区保留的最近事件数
+#define TRACE_BUFFER_SIZE 16384
+
+extern volatile LONG trace_enabled;
+
+/// @brief 开始一段记录，未开启时返回0
+#define TRACE_BEGIN() (trace_enabled ? av_gettime_relative() : 0)
+/// @brief 结束一段记录，pts 只在开启时才计算
+#define TRACE_END(name, start, pts) do { if (start) trace_record(name, start, pts); } while (0)
+
+/**
+ * @brief 记录从 start 到现在的一段事件
+ * @param name 事件名称，需要是静态字符串
+ * @param pts 相关帧的时间（单位：微秒），AV_NOPTS_VALUE 为未知
+*/
+void trace_record(const char* name, int64_t start, int64_t pts);
+/// @brief 将流的时间转换为微秒，保留 AV_NOPTS_VALUE
+int64_t trace_ts(int64_t pts, AVRational time_base);
+/// @brief 设置当前线程在导出结果中显示的名称（静态字符串）
+void trace_set_thread_name(const char* name);
+void trace_start(void);
+void trace_stop(void);
+int trace_dump(const char* path);
+#if __cplusplus
+}
+#endif
+#endif
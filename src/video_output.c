@@ -1,4 +1,32 @@
 #include "video_output.h"
+#include "trace.h"
+#include "decode.h"
+#include "sync.h"
+#include "loop.h"
+
+int init_video_buffer(PlayerSession* session) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    if (!session->has_video) return PLAYER_ERR_OK;
+    if (session->settings->low_latency) {
+        AVRational tb = { 1, 1000 };
+        AVRational rps = { session->video_frame_rate.den, session->video_frame_rate.num };
+        session->needed_video_frames = FFMAX(av_rescale_q(session->settings->target_latency, tb, rps), 1);
+    } else {
+        // 深度缓冲由数据包缓冲区负责，解码后的帧只需要保证刷新时有下一帧可用
+        session->needed_video_frames = FFMAX(session->settings->video_frame_lookahead, 2);
+    }
+    session->video_buffer = av_fifo_alloc2(session->needed_video_frames, sizeof(AVFrame*), 0);
+    if (!session->video_buffer) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to allocate video buffer.\n");
+        return PLAYER_ERR_OOM;
+    }
+    session->video_packets = av_fifo_alloc2(64, sizeof(AVPacket*), AV_FIFO_FLAG_AUTO_GROW);
+    if (!session->video_packets) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to allocate video packet buffer.\n");
+        return PLAYER_ERR_OOM;
+    }
+    return PLAYER_ERR_OK;
+}
 
 int init_video_output(PlayerSession* session) {
     if (!session) return PLAYER_ERR_NULLPTR;
@@ -28,7 +56,7 @@ int init_video_output(PlayerSession* session) {
         av_log(NULL, AV_LOG_WARNING, "Display refresh rate is 0, using 60Hz.\n");
         session->sdl_display_mode.refresh_rate = 60;
     }
-    session->renderer = SDL_CreateRenderer(session->window, -1, 0);
+    session->renderer = SDL_CreateRenderer(session->window, -1, session->settings->vsync ? SDL_RENDERER_PRESENTVSYNC : 0);
     if (!session->renderer) {
         av_log(NULL, AV_LOG_FATAL, "Failed to create renderer: %s\n", SDL_GetError());
         return PLAYER_ERR_SDL;
@@ -36,11 +64,18 @@ int init_video_output(PlayerSession* session) {
     SDL_GetWindowSize(session->window, &session->window_width, &session->window_height);
     /// #TODO: 支持YUV外的其他格式
     session->sdl_pixel_format = SDL_PIXELFORMAT_IYUV;
-    session->texture = SDL_CreateTexture(session->renderer, session->sdl_pixel_format, SDL_TEXTUREACCESS_STREAMING, session->window_width, session->window_height);
-    if (!session->texture) {
-        av_log(NULL, AV_LOG_FATAL, "Failed to create texture: %s\n", SDL_GetError());
-        return PLAYER_ERR_SDL;
+    for (int i = 0; i < VIDEO_TEXTURE_COUNT; i++) {
+        session->textures[i] = SDL_CreateTexture(session->renderer, session->sdl_pixel_format, SDL_TEXTUREACCESS_STREAMING, session->window_width, session->window_height);
+        if (!session->textures[i]) {
+            av_log(NULL, AV_LOG_FATAL, "Failed to create texture: %s\n", SDL_GetError());
+            return PLAYER_ERR_SDL;
+        }
+    }
+    if (!(session->display_frame = av_frame_alloc())) {
+        return PLAYER_ERR_OOM;
     }
+    // 不再需要先转换到中间帧再复制到纹理：省去中间帧的一次写入和一次读取
+    session->video_bytes_saved_per_frame = 2 * (int64_t)av_image_get_buffer_size(AV_PIX_FMT_YUV420P, session->window_width, session->window_height, 1);
     session->sws = sws_getContext(session->video_decoder->width, session->video_decoder->height, session->video_decoder->pix_fmt, session->window_width, session->window_height, AV_PIX_FMT_YUV420P, SWS_BICUBIC, NULL, NULL, NULL);
     if (!session->sws) {
         av_log(NULL, AV_LOG_FATAL, "Failed to create sws context.\n");
@@ -50,7 +85,150 @@ int init_video_output(PlayerSession* session) {
     return PLAYER_ERR_OK;
 }
 
-void video_display(PlayerSession *is) {
+/// @brief 按原始尺寸上传封面，缩放由渲染器完成
+static int upload_cover(PlayerSession* session) {
+    AVFrame* cover = session->cover_frame;
+    if (session->textures[0]) SDL_DestroyTexture(session->textures[0]);
+    session->textures[0] = SDL_CreateTexture(session->renderer, SDL_PIXELFORMAT_IYUV, SDL_TEXTUREACCESS_STATIC, cover->width, cover->height);
+    if (!session->textures[0]) {
+        av_log(NULL, AV_LOG_FATAL, "Failed to create texture: %s\n", SDL_GetError());
+        return PLAYER_ERR_SDL;
+    }
+    AVFrame* yuv = av_frame_alloc();
+    int re = PLAYER_ERR_OK;
+    if (!yuv) return PLAYER_ERR_OOM;
+    yuv->format = AV_PIX_FMT_YUV420P;
+    yuv->width = cover->width;
+    yuv->height = cover->height;
+    if (!(session->sws = sws_getCachedContext(session->sws, cover->width, cover->height, cover->format, cover->width, cover->height, AV_PIX_FMT_YUV420P, SWS_BICUBIC, NULL, NULL, NULL))) {
+        re = PLAYER_ERR_OOM;
+        goto end;
+    }
+    if ((re = sws_scale_frame(session->sws, yuv, cover)) < 0) {
+        goto end;
+    }
+    if (SDL_UpdateYUVTexture(session->textures[0], NULL, yuv->data[0], yuv->linesize[0], yuv->data[1], yuv->linesize[1], yuv->data[2], yuv->linesize[2]) < 0) {
+        av_log(NULL, AV_LOG_FATAL, "Failed to update texture: %s\n", SDL_GetError());
+        re = PLAYER_ERR_SDL;
+        goto end;
+    }
+    re = PLAYER_ERR_OK;
+end:
+    av_frame_free(&yuv);
+    return re;
+}
+
+int init_cover_output(PlayerSession* session) {
+    if (!session) return PLAYER_ERR_NULLPTR;
+    if (!session->has_cover) return PLAYER_ERR_OK;
+    AVFrame* cover = session->cover_frame;
+    if (!cover) return PLAYER_ERR_NULLPTR;
+    if (session->settings->hWnd) {
+        session->window = SDL_CreateWindowFrom(*session->settings->hWnd);
+        session->is_external_window = 1;
+    } else {
+        session->window = SDL_CreateWindow("Player", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, cover->width, cover->height, SDL_WINDOW_RESIZABLE);
+    }
+    if (!session->window) {
+        av_log(NULL, AV_LOG_FATAL, "Failed to create window: %s\n", SDL_GetError());
+        return PLAYER_ERR_SDL;
+    }
+    // 只在需要重绘时显示，不需要垂直同步
+    session->renderer = SDL_CreateRenderer(session->window, -1, 0);
+    if (!session->renderer) {
+        av_log(NULL, AV_LOG_FATAL, "Failed to create renderer: %s\n", SDL_GetError());
+        return PLAYER_ERR_SDL;
+    }
+    SDL_GetWindowSize(session->window, &session->window_width, &session->window_height);
+    int re = upload_cover(session);
+    if (re) return re;
+    session->video_is_init = 1;
+    return PLAYER_ERR_OK;
+}
+
+void cover_display(PlayerSession* session) {
+    if (!session || !session->has_cover || !session->video_is_init) return;
+    int w = 0, h = 0;
+    if (SDL_GetRendererOutputSize(session->renderer, &w, &h) < 0 || w <= 0 || h <= 0) return;
+    AVFrame* cover = session->cover_frame;
+    int64_t trace_start = TRACE_BEGIN();
+    SDL_SetRenderDrawColor(session->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(session->renderer);
+    if (cover && session->textures[0]) {
+        // 保持宽高比居中显示
+        SDL_Rect rect;
+        if ((int64_t)w * cover->height > (int64_t)h * cover->width) {
+            rect.h = h;
+            rect.w = (int)av_rescale(h, cover->width, cover->height);
+        } else {
+            rect.w = w;
+            rect.h = (int)av_rescale(w, cover->height, cover->width);
+        }
+        rect.x = (w - rect.w) / 2;
+        rect.y = (h - rect.h) / 2;
+        SDL_RenderCopy(session->renderer, session->textures[0], NULL, &rect);
+    }
+    SDL_RenderPresent(session->renderer);
+    TRACE_END("present cover", trace_start, AV_NOPTS_VALUE);
+}
+
+void cover_refresh(PlayerSession* session) {
+    if (!session || !session->has_cover || !session->video_is_init) return;
+    if (WaitForSingleObject(session->mutex, INFINITE) != WAIT_OBJECT_0) return;
+    if (!session->cover_changed) {
+        ReleaseMutex(session->mutex);
+        return;
+    }
+    AVFrame* cover = session->pending_cover;
+    session->pending_cover = NULL;
+    session->cover_changed = 0;
+    ReleaseMutex(session->mutex);
+    av_frame_free(&session->cover_frame);
+    session->cover_frame = cover;
+    if (!cover || upload_cover(session)) {
+        // 没有封面或上传失败时只显示黑色
+        if (session->textures[0]) SDL_DestroyTexture(session->textures[0]);
+        session->textures[0] = NULL;
+    }
+    cover_display(session);
+}
+
+/// @brief 记录新的一帧的显示时间，并更新帧间隔直方图和错过的垂直同步数
+static void record_presentation(PlayerSession* is, AVFrame* frame, int64_t now, int64_t expected_vsync, int64_t vsync_time) {
+    PlayerPacingStats* p = &is->pacing;
+    AcquireSRWLockExclusive(&is->pacing_lock);
+    PlayerPresentation* entry = &is->presentations[p->presented_frames % PLAYER_PRESENTATION_LOG_SIZE];
+    entry->pts = frame->pts != AV_NOPTS_VALUE && is->video_first_pts != INT64_MIN ? av_rescale_q_rnd(frame->pts, is->video_input_stream->time_base, AV_TIME_BASE_Q, AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX) - is->video_first_pts : AV_NOPTS_VALUE;
+    entry->present_time = now;
+    p->vsync_interval = vsync_time;
+    if (is->settings->vsync && now - expected_vsync > vsync_time / 2) {
+        // 比预期的垂直同步晚了至少半个周期
+        p->missed_vsyncs += (now - expected_vsync + vsync_time / 2) / vsync_time;
+    }
+    if (p->presented_frames && p->last_present_time != INT64_MIN) {
+        int64_t vsyncs = (now - p->last_present_time + vsync_time / 2) / vsync_time;
+        p->interval_histogram[FFMIN(FFMAX(vsyncs, 0), PLAYER_PACING_HISTOGRAM_SIZE - 1)]++;
+    }
+    p->last_present_time = now;
+    p->presented_frames++;
+    ReleaseSRWLockExclusive(&is->pacing_lock);
+}
+
+/// @brief 把纹理铺满窗口并提交
+static void present_texture(PlayerSession* is, SDL_Texture* texture, int64_t frame_pts) {
+    SDL_Rect rect;
+    rect.x = 0;
+    rect.y = 0;
+    rect.w = is->window_width;
+    rect.h = is->window_height;
+    int64_t trace_start = TRACE_BEGIN();
+    SDL_RenderClear(is->renderer);
+    SDL_RenderCopy(is->renderer, texture, NULL, &rect);
+    SDL_RenderPresent(is->renderer);
+    TRACE_END("present", trace_start, frame_pts);
+}
+
+void video_display(PlayerSession *is, int64_t expected_vsync, int64_t vsync_time) {
     if (!is) return;
     if (!is->has_video) return;
     if (!is->video_is_init) return;
@@ -66,24 +244,84 @@ void video_display(PlayerSession *is) {
         ReleaseMutex(is->video_mutex);
         return;
     }
+    if (is->video_head_displayed && is->head_texture) {
+        // 同一帧再次显示：纹理中已经是这一帧，不需要重新转换和上传
+        SDL_Texture* texture = is->head_texture;
+        ReleaseMutex(is->video_mutex);
+        present_texture(is, texture, AV_NOPTS_VALUE);
+        if (is->settings->vsync) is->last_vsync_timestamp = av_gettime();
+        is->video_repeated_frames++;
+        return;
+    }
+    // 释放锁后切换文件可能清空缓冲区，先持有该帧的引用
+    re = av_frame_ref(is->display_frame, frame);
     ReleaseMutex(is->video_mutex);
+    if (re < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to reference video frame: %s (%i)\n", av_err2str(re), re);
+        return;
+    }
+    frame = is->display_frame;
     av_log(NULL, AV_LOG_DEBUG, "Displaying video frame.\n");
-    AVFrame* target = av_frame_alloc();
-    sws_scale_frame(is->sws, target, frame);
-    SDL_Rect rect;
-    rect.x = 0;
-    rect.y = 0;
-    rect.w = is->window_width;
-    rect.h = is->window_height;
-    SDL_UpdateYUVTexture(is->texture, NULL, target->data[0], target->linesize[0], target->data[1], target->linesize[1], target->data[2], target->linesize[2]);
-    av_frame_free(&target);
-    SDL_RenderClear(is->renderer);
-    SDL_RenderCopy(is->renderer, is->texture, NULL, &rect);
-    SDL_RenderPresent(is->renderer);
+    // 切换到下一个文件后输入尺寸可能变化
+    is->sws = sws_getCachedContext(is->sws, frame->width, frame->height, frame->format, is->window_width, is->window_height, AV_PIX_FMT_YUV420P, SWS_BICUBIC, NULL, NULL, NULL);
+    if (!is->sws) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to create sws context.\n");
+        goto end;
+    }
+    // 轮流使用多个纹理，避免等待上一帧上传完成
+    SDL_Texture* texture = is->textures[is->texture_index];
+    is->texture_index = (is->texture_index + 1) % VIDEO_TEXTURE_COUNT;
+    void* pixels = NULL;
+    int pitch = 0;
+    int64_t frame_pts = 0;
+    int64_t trace_start = TRACE_BEGIN();
+    if (trace_start) frame_pts = trace_ts(frame->pts, is->video_input_stream->time_base);
+    if (SDL_LockTexture(texture, NULL, &pixels, &pitch) < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Failed to lock texture: %s\n", SDL_GetError());
+        goto end;
+    }
+    // IYUV 纹理的内存布局为 Y、U、V 三个连续的平面，色度平面的行宽与 SDL 相同向上取整
+    uint8_t* dst[4] = { NULL };
+    int dst_linesize[4] = { 0 };
+    dst[0] = (uint8_t*)pixels;
+    dst_linesize[0] = pitch;
+    dst[1] = dst[0] + (size_t)pitch * is->window_height;
+    dst_linesize[1] = (pitch + 1) / 2;
+    dst[2] = dst[1] + (size_t)((pitch + 1) / 2) * ((is->window_height + 1) / 2);
+    dst_linesize[2] = (pitch + 1) / 2;
+    TRACE_END("SDL_LockTexture", trace_start, frame_pts);
+    trace_start = TRACE_BEGIN();
+    sws_scale(is->sws, (const uint8_t* const*)frame->data, frame->linesize, 0, frame->height, dst, dst_linesize);
+    TRACE_END("sws_scale", trace_start, frame_pts);
+    trace_start = TRACE_BEGIN();
+    SDL_UnlockTexture(texture);
+    TRACE_END("texture upload", trace_start, frame_pts);
+    // 每个不同的帧只上传一次，节省的字节数也只计一次
+    is->video_bytes_saved += is->video_bytes_saved_per_frame;
+    is->head_texture = texture;
+    present_texture(is, texture, frame_pts);
+    int64_t now = av_gettime();
+    // 开启垂直同步时 SDL_RenderPresent 会等到垂直同步后才返回
+    if (is->settings->vsync) is->last_vsync_timestamp = now;
+    if (!is->video_head_displayed) {
+        is->video_head_displayed = 1;
+        record_presentation(is, frame, now, expected_vsync, vsync_time);
+    } else {
+        is->video_repeated_frames++;
+    }
+end:
+    av_frame_unref(is->display_frame);
+}
+
+void request_video_refresh(PlayerSession* is) {
+    if (!is) return;
+    InterlockedExchange(&is->refresh_requested, 1);
+    wake_event_loop(is);
 }
 
 Uint32 sdl_refresh_timer_cb(Uint32 interval, void *opaque) {
-    video_refresh_timer(opaque);
+    // 开启垂直同步时显示会阻塞一个刷新周期，不能在所有会话共用的定时器线程中进行
+    request_video_refresh((PlayerSession*)opaque);
     return 0;
 }
 
@@ -94,6 +332,48 @@ void schedule_refresh(PlayerSession *is, int delay) {
     av_log(NULL, AV_LOG_DEBUG, "Scheduled refresh on %d ms.\n", delay);
 }
 
+int64_t get_master_clock(PlayerSession* is, int64_t now, int64_t* diff, int64_t* audio_diff) {
+    if (!is) return 0;
+    if (!is->has_audio) {
+        // 没有音频时使用系统时钟
+        if (is->clock_start_timestamp == INT64_MIN) return 0;
+        return is->is_playing ? now - is->clock_start_timestamp : is->clock_paused_pos;
+    }
+    int64_t d = is->first_pts != INT64_MIN && is->video_first_pts != INT64_MIN ? is->first_pts - is->video_first_pts : 0;
+    if (diff) *diff = d;
+    if (audio_diff) *audio_diff = is->last_pts_timestamp != INT64_MIN ? now - is->last_pts_timestamp : 0;
+    return video_sync_audio_clock(is->pts, d, is->last_pts_timestamp, now, is->audio_device_latency);
+}
+
+/// @brief 把流时间基的时间换算为播放时间（微秒，已按播放速度换算）
+static int64_t frame_time_to_output(PlayerSession* is, int64_t ts) {
+    int64_t t = av_rescale_q_rnd(ts, is->video_input_stream->time_base, AV_TIME_BASE_Q, AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
+    return av_rescale(t, is->speed.den, is->speed.num);
+}
+
+void get_video_sync_frames(PlayerSession* is, VideoSyncParams* params, int64_t* pts, int64_t* duration) {
+    if (!is || !params || !pts || !duration) return;
+    AVRational rate = av_mul_q(is->video_frame_rate, is->speed);
+    // 帧率未知时按 25 fps 处理
+    if (!rate.num || !rate.den) rate = av_mul_q(av_make_q(25, 1), is->speed);
+    params->frame_time = av_rescale_q(1, av_make_q(rate.den, rate.num), AV_TIME_BASE_Q);
+    params->frame_pts = pts;
+    params->frame_duration = duration;
+    params->frame_pts_count = FFMIN((int)av_fifo_can_read(is->video_buffer), VIDEO_SYNC_MAX_FRAMES);
+    for (int i = 0; i < params->frame_pts_count; i++) {
+        AVFrame* frame;
+        pts[i] = INT64_MIN;
+        duration[i] = 0;
+        if (av_fifo_peek(is->video_buffer, &frame, 1, i) < 0) continue;
+        // 上一个文件（无缝切换后仍在缓冲区中）的帧时间无法与当前文件比较，按名义帧时长显示
+        if ((uintptr_t)frame->opaque != (uintptr_t)is->item_index) continue;
+        // 可变帧率的视频每帧按自己的时间戳和时长显示
+        int64_t ts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+        if (ts != AV_NOPTS_VALUE) pts[i] = frame_time_to_output(is, ts);
+        if (frame->duration > 0) duration[i] = frame_time_to_output(is, frame->duration);
+    }
+}
+
 void video_refresh_timer(void *userdata) {
     if (!userdata) return;
     PlayerSession* is = (PlayerSession*)userdata;
@@ -109,39 +389,46 @@ void video_refresh_timer(void *userdata) {
         av_log(NULL, AV_LOG_ERROR, "Failed to wait for video mutex: %d\n", re);
         return;
     }
-    int64_t diff = is->first_pts != INT64_MIN && is->video_first_pts != INT64_MIN ? is->first_pts - is->video_first_pts : 0;
-    int64_t audio_diff = is->last_pts_timestamp != INT64_MIN ? av_gettime() - is->last_pts_timestamp : 0;
-    int64_t curpos = is->pts - diff + audio_diff;
-    int64_t frame_time = av_rescale_q(1, av_make_q(1, is->sdl_display_mode.refresh_rate), AV_TIME_BASE_Q);
-    int64_t true_frame_time = av_rescale_q(1, av_make_q(is->video_decoder->framerate.den, is->video_decoder->framerate.num), AV_TIME_BASE_Q);
-    int64_t true_next_frame_time = is->video_pts + true_frame_time;
-    while (curpos >= true_next_frame_time) {
+    int64_t diff = 0, audio_diff = 0;
+    int64_t now = av_gettime();
+    VideoSyncParams params;
+    VideoSyncDecision d;
+    int64_t frame_pts[VIDEO_SYNC_MAX_FRAMES], frame_duration[VIDEO_SYNC_MAX_FRAMES];
+    memset(&params, 0, sizeof(VideoSyncParams));
+    params.clock = get_master_clock(is, now, &diff, &audio_diff);
+    params.now = now;
+    params.last_vsync = is->settings->vsync ? is->last_vsync_timestamp : INT64_MIN;
+    params.vsync_time = av_rescale_q(1, av_make_q(1, is->sdl_display_mode.refresh_rate), AV_TIME_BASE_Q);
+    params.video_pts = is->video_pts;
+    params.frames = (int)av_fifo_can_read(is->video_buffer);
+    params.eof = is->video_is_eof;
+    params.head_displayed = is->video_head_displayed;
+    get_video_sync_frames(is, &params, frame_pts, frame_duration);
+    video_sync_decide(&params, &d);
+    for (int i = 0; i < d.advance; i++) {
         AVFrame* frame;
-        if (av_fifo_can_read(is->video_buffer) == 0) {
-            ReleaseMutex(is->video_mutex);
-            av_log(NULL, AV_LOG_DEBUG, "No enough video frame in buffer.\n");
-            return;
-        }
-        int re = av_fifo_read(is->video_buffer, &frame, 1);
-        if (re < 0) {
-            av_log(NULL, AV_LOG_ERROR, "Failed to read video frame from buffer: %s (%i)\n", av_err2str(re), re);
-            ReleaseMutex(is->video_mutex);
-            return;
-        }
+        if (av_fifo_read(is->video_buffer, &frame, 1) < 0) break;
         av_frame_free(&frame);
-        av_log(NULL, AV_LOG_DEBUG, "Discard a video frame. diff=%lld, audio_diff=%lld, curpos=%lld, true_next_frame_time=%lld\n", diff, audio_diff, curpos, true_next_frame_time);
-        is->video_pts += true_frame_time;
-        true_next_frame_time = is->video_pts + true_frame_time;
-    }
-    int64_t next_frame_time = is->video_pts + frame_time;
-    // 允许提前 1 / 4 帧
-    while (curpos >= next_frame_time - frame_time / 4) {
-        av_log(NULL, AV_LOG_DEBUG, "Skip a video frame. diff=%lld, audio_diff=%lld, curpos=%lld, next_frame_time=%lld\n", diff, audio_diff, curpos, next_frame_time);
-        next_frame_time += frame_time;
-    }
-    int64_t delay = next_frame_time - curpos;
-    av_log(NULL, AV_LOG_DEBUG, "diff=%lld, audio_diff=%lld, curpos=%lld, true_next_frame_time=%lld, next_frame_time=%lld, delay=%lld\n", diff, audio_diff, curpos, true_next_frame_time, next_frame_time, delay);
-    is->next_video_timestamp = av_gettime() + delay;
-    schedule_refresh(is, delay / 1000);
-    video_display(is);
+    }
+    if (d.advance) {
+        is->video_head_displayed = 0;
+        if (d.dropped) av_log(NULL, AV_LOG_DEBUG, "Discard %d video frame(s). diff=%lld, audio_diff=%lld, display_pos=%lld\n", d.dropped, diff, audio_diff, d.display_pos);
+    }
+    is->video_pts = d.video_pts;
+    // 取出帧后缓冲区有了空间，卡顿时也要让解码线程继续
+    if (d.advance || (d.underflow && !is->video_is_eof)) wake_decode_loop(is);
+    is->video_dropped_frames += d.dropped;
+    update_video_skip_level(is, d.dropped);
+    if (d.underflow) {
+        if (!is->video_is_eof) is->video_stalls++;
+        ReleaseMutex(is->video_mutex);
+        av_log(NULL, AV_LOG_DEBUG, "No enough video frame in buffer.\n");
+        // 等待解码线程补充数据后重试
+        schedule_refresh(is, (int)(d.delay / 1000));
+        return;
+    }
+    av_log(NULL, AV_LOG_DEBUG, "diff=%lld, audio_diff=%lld, curpos=%lld, display_pos=%lld, video_pts=%lld, delay=%lld\n", diff, audio_diff, params.clock, d.display_pos, d.video_pts, d.delay);
+    is->next_video_timestamp = now + d.delay;
+    schedule_refresh(is, (int)(d.delay / 1000));
+    video_display(is, d.next_vsync, params.vsync_time);
 }
@@ -4,11 +4,42 @@
 extern "C" {
 #endif
 #include "core.h"
+#include "sync.h"
+int init_video_buffer(PlayerSession* session);
 int init_video_output(PlayerSession* session);
+/// @brief 创建窗口并上传封面（只上传一次）
+int init_cover_output(PlayerSession* session);
+/// @brief 重新绘制封面，仅在窗口需要重绘或大小改变时调用
+void cover_display(PlayerSession* session);
+/// @brief 切换文件后换上新文件的封面并重新绘制，只在事件线程中调用
+void cover_refresh(PlayerSession* session);
 Uint32 sdl_refresh_timer_cb(Uint32 interval, void *opaque);
 void schedule_refresh(PlayerSession *is, int delay);
-void video_display(PlayerSession *is);
+/**
+ * @brief 显示视频缓冲区的第一帧
+ * @param expected_vsync 预期显示的垂直同步时间
+ * @param vsync_time 垂直同步周期
+*/
+void video_display(PlayerSession *is, int64_t expected_vsync, int64_t vsync_time);
+/**
+ * @brief 获取当前播放位置（相对于视频第一帧）
+ *
+ * 有音频时以音频为准，否则使用系统时钟
+ * @param now 当前系统时间
+ * @param diff 用于接收音视频第一帧的时间差（可选）
+ * @param audio_diff 用于接收距离上次更新音频数据的时间（可选）
+*/
+int64_t get_master_clock(PlayerSession* is, int64_t now, int64_t* diff, int64_t* audio_diff);
+/**
+ * @brief 填充缓冲区中各帧的时间和时长（已按播放速度换算），供 video_sync_frame_duration 使用
+ * @param pts 至少 VIDEO_SYNC_MAX_FRAMES 个元素
+ * @param duration 至少 VIDEO_SYNC_MAX_FRAMES 个元素
+*/
+void get_video_sync_frames(PlayerSession* is, VideoSyncParams* params, int64_t* pts, int64_t* duration);
+/// @brief 刷新画面，只在事件线程中调用
 void video_refresh_timer(void *userdata);
+/// @brief 请求事件线程刷新画面（可在任意线程中调用）
+void request_video_refresh(PlayerSession* is);
 #if __cplusplus
 }
 #endif
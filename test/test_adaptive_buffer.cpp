@@ -0,0 +1,36 @@
+#include <windows.h>
+#include "../player.h"
+
+// 使用自适应缓冲区播放 10 秒，输出卡顿次数和缓冲区大小的调整记录
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_adaptive_buffer.log", 0, AV_LOG_VERBOSE);
+    PlayerSettings* settings = player_settings_init();
+    if (!settings) return 1;
+    if (player_settings_set_adaptive_buffer(settings, 200, 4000) || player_settings_set_input_format(settings, "lavfi")) {
+        player_settings_free(&settings);
+        return 1;
+    }
+    PlayerSession* ses = nullptr;
+    int re = player_create2("sine=frequency=440:sample_rate=48000", &ses, settings);
+    if (re != PLAYER_ERR_OK || wait_player_inited(ses)) {
+        player_log(AV_LOG_ERROR, "Failed to create player session: %s\n", player_get_err_msg2(re));
+        player_free(&ses);
+        player_settings_free(&settings);
+        return 1;
+    }
+    player_wait_until_buffer_is_full(ses);
+    player_play(ses);
+    Sleep(10000);
+    PlayerStats stats;
+    player_get_stats(ses, &stats);
+    PlayerBufferAdjustment entries[PLAYER_BUFFER_ADJUSTMENT_LOG_SIZE];
+    int count = player_get_buffer_adjustments(ses, entries, PLAYER_BUFFER_ADJUSTMENT_LOG_SIZE);
+    player_log(AV_LOG_INFO, "Buffer size: %u ms, audio underruns: %llu, video stalls: %llu, adjustments: %llu\n", stats.audio_buffer_size, stats.audio_underruns, stats.video_stalls, stats.buffer_adjustments);
+    for (int i = 0; i < count; i++) {
+        player_log(AV_LOG_INFO, "%lld: %u ms -> %u ms (reason %d)\n", entries[i].time, entries[i].old_size, entries[i].new_size, entries[i].reason);
+    }
+    int result = stats.audio_buffer_size >= 200 && stats.audio_buffer_size <= 4000 ? 0 : 1;
+    player_free(&ses);
+    player_settings_free(&settings);
+    return result;
+}
@@ -0,0 +1,69 @@
+#include <windows.h>
+#include "../player.h"
+#include <string>
+#include "wchar_util.h"
+
+// Function to open a file dialog and get the selected file path
+std::string MyGetOpenFileName() {
+    wchar_t path[MAX_PATH] = L"";
+    OPENFILENAMEW ofn;
+    ZeroMemory(&ofn, sizeof(ofn));
+    ofn.lStructSize = sizeof(OPENFILENAMEW);
+    ofn.hwndOwner = NULL;
+    ofn.lpstrFilter = L"All Files (*.*)\0";
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_EXPLORER | OFN_FILEMUSTEXIST | OFN_HIDEREADONLY;
+    ofn.lpstrDefExt = L"";
+
+    if (GetOpenFileNameW(&ofn)) {
+        std::string tmp;
+        if (!wchar_util::wstr_to_str(tmp, ofn.lpstrFile, CP_UTF8)) {
+            return "";
+        }
+        return tmp;
+    }
+
+    return "";
+}
+
+static int64_t get_cpu_time() {
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (int64_t)((k.QuadPart + u.QuadPart) / 10);
+}
+
+// 播放带封面的音乐文件（如 MP3、FLAC），封面应被选中并显示，CPU 占用应与纯音频相近
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_cover.log", 0, AV_LOG_VERBOSE);
+    std::string path = MyGetOpenFileName();
+    if (path.empty()) {
+        return 0;
+    }
+    PlayerSession* ses = nullptr;
+    int re = player_create(path.c_str(), &ses);
+    if (re != PLAYER_ERR_OK) {
+        player_log(AV_LOG_ERROR, "Failed to create player session: %s\n", player_get_err_msg2(re));
+        return 1;
+    }
+    int result = 1;
+    for (int i = 0; i < player_get_stream_count(ses); i++) {
+        PlayerStreamInfo info;
+        if (!player_get_stream_info(ses, i, &info) && info.is_attached_pic && info.is_selected) {
+            player_log(AV_LOG_INFO, "Cover stream %d: %s %dx%d\n", i, info.codec, info.width, info.height);
+            result = 0;
+        }
+    }
+    player_wait_until_buffer_is_full(ses);
+    player_play(ses);
+    int64_t cpu = get_cpu_time();
+    Sleep(5000);
+    player_log(AV_LOG_INFO, "CPU time in 5 s: %lld us\n", get_cpu_time() - cpu);
+    player_free(&ses);
+    return result;
+}
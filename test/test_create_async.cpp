@@ -0,0 +1,63 @@
+#include <windows.h>
+#include "../player.h"
+
+struct CreateResult {
+    HANDLE event;
+    PlayerSession* session;
+    int err;
+};
+
+static void on_created(void* userdata, PlayerSession* session, int err) {
+    CreateResult* r = (CreateResult*)userdata;
+    r->session = session;
+    r->err = err;
+    SetEvent(r->event);
+}
+
+// 异步创建一个会话并播放 2 秒，再打开一个连接不上的地址并在 200ms 后取消，取消后应立即收到回调
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_create_async.log", 0, AV_LOG_VERBOSE);
+    PlayerSettings* settings = player_settings_init();
+    if (!settings) return 1;
+    if (player_settings_set_input_format(settings, "lavfi")) {
+        player_settings_free(&settings);
+        return 1;
+    }
+    int result = 1;
+    CreateResult r = { CreateEventW(nullptr, FALSE, FALSE, nullptr), nullptr, 0 };
+    PlayerCreateRequest* request = nullptr;
+    if (!r.event) goto end;
+    if (player_create_async("testsrc=size=640x360:rate=30", settings, on_created, &r, &request)) goto end;
+    WaitForSingleObject(r.event, INFINITE);
+    player_free_create_request(&request);
+    if (r.err || !r.session) {
+        player_log(AV_LOG_ERROR, "Failed to create player session: %s\n", player_get_err_msg2(r.err));
+        goto end;
+    }
+    wait_player_inited(r.session);
+    player_wait_until_buffer_is_full(r.session);
+    player_play(r.session);
+    Sleep(2000);
+    player_free(&r.session);
+    {
+        LARGE_INTEGER freq, start, end;
+        QueryPerformanceFrequency(&freq);
+        // 不可路由的地址，连接会一直等待到超时
+        if (player_create_async("http://10.255.255.1/test.mp4", nullptr, on_created, &r, &request)) goto end;
+        Sleep(200);
+        QueryPerformanceCounter(&start);
+        player_cancel_create(request);
+        WaitForSingleObject(r.event, INFINITE);
+        QueryPerformanceCounter(&end);
+        player_free_create_request(&request);
+        double elapsed = (double)(end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart;
+        player_log(AV_LOG_INFO, "Cancelled in %.2f ms: %s\n", elapsed, player_get_err_msg2(r.err));
+        player_free(&r.session);
+        if (r.err == PLAYER_ERR_CANCELLED && elapsed < 1000) result = 0;
+    }
+end:
+    player_free_create_request(&request);
+    if (r.event) CloseHandle(r.event);
+    player_settings_free(&settings);
+    return result;
+}
@@ -0,0 +1,55 @@
+#include <windows.h>
+#include "../player.h"
+
+// 统计暂停和缓冲区已满的稳定播放时解码线程和事件线程每秒被唤醒的次数
+#define MEASURE_TIME 2000
+
+static void measure(PlayerSession* ses, double* decode, double* event) {
+    PlayerStats before, after;
+    player_get_stats(ses, &before);
+    Sleep(MEASURE_TIME);
+    player_get_stats(ses, &after);
+    *decode = (after.decode_wakeups - before.decode_wakeups) * 1000.0 / MEASURE_TIME;
+    *event = (after.event_wakeups - before.event_wakeups) * 1000.0 / MEASURE_TIME;
+}
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_idle_wakeups.log", 0, AV_LOG_VERBOSE);
+    PlayerSettings* settings = player_settings_init();
+    if (!settings) return 1;
+    if (player_settings_set_input_format(settings, "lavfi")) {
+        player_settings_free(&settings);
+        return 1;
+    }
+    PlayerSession* ses = nullptr;
+    int re = player_create2("testsrc=size=320x240:rate=30[out0];sine=frequency=440[out1]", &ses, settings);
+    if (re != PLAYER_ERR_OK || wait_player_inited(ses)) {
+        player_log(AV_LOG_ERROR, "Failed to create player session: %s\n", player_get_err_msg2(re));
+        player_free(&ses);
+        player_settings_free(&settings);
+        return 1;
+    }
+    int result = 0;
+    double decode = 0, event = 0;
+    // 创建后尚未播放，缓冲区填满后不应再被唤醒
+    player_wait_until_buffer_is_full(ses);
+    Sleep(200);
+    measure(ses, &decode, &event);
+    player_log(AV_LOG_INFO, "Buffered, not started: decode %.1f/s, event %.1f/s\n", decode, event);
+    if (decode > 1 || event > 2) result = 1;
+    // 稳定播放时解码线程只在取出数据后被唤醒，事件线程只在需要刷新画面时被唤醒，次数与音频回调和帧率相当
+    player_play(ses);
+    Sleep(500);
+    measure(ses, &decode, &event);
+    player_log(AV_LOG_INFO, "Playing: decode %.1f/s, event %.1f/s\n", decode, event);
+    if (decode > 200 || event > 200) result = 1;
+    // 暂停后缓冲区重新填满，之后不应再被唤醒
+    player_pause(ses);
+    Sleep(200);
+    measure(ses, &decode, &event);
+    player_log(AV_LOG_INFO, "Paused: decode %.1f/s, event %.1f/s\n", decode, event);
+    if (decode > 1 || event > 2) result = 1;
+    player_free(&ses);
+    player_settings_free(&settings);
+    return result;
+}
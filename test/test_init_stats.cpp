@@ -0,0 +1,33 @@
+#include <windows.h>
+#include "../player.h"
+
+// 创建同时有音频和视频的会话，输出各初始化步骤的耗时
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_init_stats.log", 0, AV_LOG_VERBOSE);
+    PlayerSettings* settings = player_settings_init();
+    if (!settings) return 1;
+    if (player_settings_set_input_format(settings, "lavfi")) {
+        player_settings_free(&settings);
+        return 1;
+    }
+    PlayerSession* ses = nullptr;
+    int re = player_create2("testsrc=size=640x360:rate=30[out0];sine=frequency=440[out1]", &ses, settings);
+    if (re != PLAYER_ERR_OK) {
+        player_log(AV_LOG_ERROR, "Failed to create player session: %s\n", player_get_err_msg2(re));
+        player_settings_free(&settings);
+        return 1;
+    }
+    const char* names[PLAYER_INIT_STEP_COUNT] = { "open input", "find streams", "SDL init", "audio decoder", "video decoder", "audio output", "video output" };
+    PlayerInitStats stats;
+    player_get_init_stats(ses, &stats);
+    int64_t sum = 0;
+    for (int i = 0; i < PLAYER_INIT_STEP_COUNT; i++) {
+        player_log(AV_LOG_INFO, "%s: start %lld us, duration %lld us\n", names[i], stats.steps[i].start, stats.steps[i].duration);
+        sum += stats.steps[i].duration;
+    }
+    player_log(AV_LOG_INFO, "Total: %lld us, sum of steps: %lld us\n", stats.total, sum);
+    int result = stats.total > 0 && stats.steps[PLAYER_INIT_OPEN_INPUT].duration > 0 && stats.steps[PLAYER_INIT_AUDIO_OUTPUT].duration > 0 ? 0 : 1;
+    player_free(&ses);
+    player_settings_free(&settings);
+    return result;
+}
@@ -0,0 +1,42 @@
+#include <windows.h>
+#include "../player.h"
+
+// 使用 lavfi 生成实时的音视频源，测试低延迟模式下的端到端延迟
+#define LIVE_SOURCE "testsrc=size=640x360:rate=30,realtime[out0];sine=frequency=440,arealtime[out1]"
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_low_latency.log", 0, AV_LOG_VERBOSE);
+    PlayerSettings* settings = player_settings_init();
+    if (!settings) return 1;
+    player_settings_set_low_latency(settings, 1);
+    player_settings_set_target_latency(settings, 40);
+    if (player_settings_set_input_format(settings, "lavfi")) {
+        player_settings_free(&settings);
+        return 1;
+    }
+    PlayerSession* ses = nullptr;
+    int re = player_create2(LIVE_SOURCE, &ses, settings);
+    if (re != PLAYER_ERR_OK) {
+        player_log(AV_LOG_ERROR, "Failed to create player session: %s\n", player_get_err_msg2(re));
+        player_settings_free(&settings);
+        return 1;
+    }
+    if (wait_player_inited(ses)) {
+        player_free(&ses);
+        player_settings_free(&settings);
+        return 1;
+    }
+    player_play(ses);
+    PlayerStats stats;
+    int64_t max_latency = 0;
+    for (int i = 0; i < 10 && player_is_playing(ses); i++) {
+        Sleep(1000);
+        if (player_get_stats(ses, &stats)) break;
+        if (stats.latency > max_latency) max_latency = stats.latency;
+        player_log(AV_LOG_INFO, "Latency: %lld us, dropped samples: %llu, dropped frames: %llu\n", stats.latency, stats.live_dropped_samples, stats.video_dropped_frames);
+    }
+    player_log(AV_LOG_INFO, "Max latency: %lld us\n", max_latency);
+    player_free(&ses);
+    player_settings_free(&settings);
+    return 0;
+}
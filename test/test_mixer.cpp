@@ -0,0 +1,61 @@
+#include <windows.h>
+#include "../player.h"
+#include <string>
+
+#define SESSIONS 16
+
+// 16 个音频会话共用一个音频设备，测试音量、静音和独奏，并记录混音耗时
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_mixer.log", 0, AV_LOG_VERBOSE);
+    PlayerSettings* settings = player_settings_init();
+    if (!settings) return 1;
+    player_settings_set_shared_audio_output(settings, 1);
+    if (player_settings_set_input_format(settings, "lavfi")) {
+        player_settings_free(&settings);
+        return 1;
+    }
+    PlayerSession* sessions[SESSIONS] = {};
+    int result = 1;
+    PlayerMixerStats mixer;
+    for (int i = 0; i < SESSIONS; i++) {
+        std::string source = "sine=frequency=" + std::to_string(220 + i * 55) + ":sample_rate=44100";
+        int re = player_create2(source.c_str(), &sessions[i], settings);
+        if (re != PLAYER_ERR_OK || wait_player_inited(sessions[i])) {
+            player_log(AV_LOG_ERROR, "Failed to create player session %d: %s\n", i, player_get_err_msg2(re));
+            goto end;
+        }
+        player_set_gain(sessions[i], 1.0f / SESSIONS);
+    }
+    for (int i = 0; i < SESSIONS; i++) {
+        player_wait_until_buffer_is_full(sessions[i]);
+        player_play(sessions[i]);
+    }
+    Sleep(2000);
+    player_set_solo(sessions[0], 1);
+    player_set_gain(sessions[0], 0.5f);
+    Sleep(2000);
+    player_set_solo(sessions[0], 0);
+    for (int i = 1; i < SESSIONS; i += 2) {
+        player_set_mute(sessions[i], 1);
+    }
+    Sleep(2000);
+    player_get_mixer_stats(&mixer);
+    player_log(AV_LOG_INFO, "Mixer: %d sessions, %dHz, %d channels, %llu callbacks, %.2f us per callback, last %lld us\n", mixer.sessions, mixer.sample_rate, mixer.channels, mixer.callbacks, mixer.callbacks ? (double)mixer.total_time / mixer.callbacks : 0.0, mixer.last_time);
+    if (mixer.sessions != SESSIONS || !mixer.callbacks) goto end;
+    result = 0;
+    for (int i = 0; i < SESSIONS; i++) {
+        PlayerStats stats;
+        player_get_stats(sessions[i], &stats);
+        player_log(AV_LOG_INFO, "Session %d: %llu mix calls, %.2f us per call\n", i, stats.audio_mix_calls, stats.audio_mix_calls ? (double)stats.audio_mix_time / stats.audio_mix_calls : 0.0);
+        // 静音和未独奏的会话同样要继续取出数据，每个周期都应处理
+        if (stats.audio_mix_calls * 2 < mixer.callbacks) result = 1;
+    }
+end:
+    for (int i = 0; i < SESSIONS; i++) {
+        player_free(&sessions[i]);
+    }
+    player_get_mixer_stats(&mixer);
+    if (mixer.sessions) result = 1;
+    player_settings_free(&settings);
+    return result;
+}
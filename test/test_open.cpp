@@ -0,0 +1,84 @@
+#include <windows.h>
+#include "../player.h"
+#include <string>
+#include "wchar_util.h"
+
+#define ROUNDS 5
+
+// Function to open a file dialog and get the selected file path
+std::string MyGetOpenFileName() {
+    wchar_t path[MAX_PATH] = L"";
+    OPENFILENAMEW ofn;
+    ZeroMemory(&ofn, sizeof(ofn));
+    ofn.lStructSize = sizeof(OPENFILENAMEW);
+    ofn.hwndOwner = NULL;
+    ofn.lpstrFilter = L"All Files (*.*)\0";
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_EXPLORER | OFN_FILEMUSTEXIST | OFN_HIDEREADONLY;
+    ofn.lpstrDefExt = L"";
+
+    if (GetOpenFileNameW(&ofn)) {
+        std::string tmp;
+        if (!wchar_util::wstr_to_str(tmp, ofn.lpstrFile, CP_UTF8)) {
+            return "";
+        }
+        return tmp;
+    }
+
+    return "";
+}
+
+static double elapsed_ms(LARGE_INTEGER start, LARGE_INTEGER freq) {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (double)(now.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart;
+}
+
+// 比较每次重新创建会话和在现有会话中打开文件，直到可以开始播放所需的时间
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_open.log", 0, AV_LOG_VERBOSE);
+    std::string path = MyGetOpenFileName();
+    if (path.empty()) {
+        return 0;
+    }
+    LARGE_INTEGER freq, start;
+    QueryPerformanceFrequency(&freq);
+    PlayerSession* ses = nullptr;
+    double create_ms = 0, open_ms = 0;
+    for (int i = 0; i < ROUNDS; i++) {
+        QueryPerformanceCounter(&start);
+        int re = player_create(path.c_str(), &ses);
+        if (re != PLAYER_ERR_OK || wait_player_inited(ses)) {
+            player_log(AV_LOG_ERROR, "Failed to create player session: %s\n", player_get_err_msg2(re));
+            player_free(&ses);
+            return 1;
+        }
+        player_wait_until_buffer_is_full(ses);
+        player_free(&ses);
+        create_ms += elapsed_ms(start, freq);
+    }
+    if (player_create(path.c_str(), &ses) || wait_player_inited(ses)) {
+        player_free(&ses);
+        return 1;
+    }
+    player_wait_until_buffer_is_full(ses);
+    player_play(ses);
+    Sleep(1000);
+    for (int i = 0; i < ROUNDS; i++) {
+        QueryPerformanceCounter(&start);
+        int re = player_open(ses, path.c_str());
+        if (re != PLAYER_ERR_OK) {
+            player_log(AV_LOG_ERROR, "Failed to open file in session: %s\n", player_get_err_msg2(re));
+            player_free(&ses);
+            return 1;
+        }
+        player_wait_until_buffer_is_full(ses);
+        open_ms += elapsed_ms(start, freq);
+        player_play(ses);
+        Sleep(1000);
+    }
+    player_free(&ses);
+    player_log(AV_LOG_INFO, "Create + free: %.2f ms, player_open: %.2f ms (average of %d)\n", create_ms / ROUNDS, open_ms / ROUNDS, ROUNDS);
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include <windows.h>
+#include "../player.h"
+
+// 23.976 fps 的视频源，在 60 Hz 下应为 3:2 交替的节奏
+#define PACING_SOURCE "testsrc=size=640x360:rate=24000/1001"
+#define FRAME_TIME (1001000000LL / 24000)
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_pacing.log", 0, AV_LOG_VERBOSE);
+    PlayerSettings* settings = player_settings_init();
+    if (!settings) return 1;
+    player_settings_set_vsync(settings, 1);
+    if (player_settings_set_input_format(settings, "lavfi")) {
+        player_settings_free(&settings);
+        return 1;
+    }
+    PlayerSession* ses = nullptr;
+    int re = player_create2(PACING_SOURCE, &ses, settings);
+    if (re != PLAYER_ERR_OK) {
+        player_log(AV_LOG_ERROR, "Failed to create player session: %s\n", player_get_err_msg2(re));
+        player_settings_free(&settings);
+        return 1;
+    }
+    if (wait_player_inited(ses)) {
+        player_free(&ses);
+        player_settings_free(&settings);
+        return 1;
+    }
+    player_wait_until_buffer_is_full(ses);
+    player_play(ses);
+    // 跳过开始时不稳定的部分
+    Sleep(1000);
+    player_reset_pacing_stats(ses);
+    Sleep(10000);
+    PlayerPacingStats stats;
+    re = player_get_pacing_stats(ses, &stats);
+    player_free(&ses);
+    player_settings_free(&settings);
+    if (re || !stats.vsync_interval) return 1;
+    uint64_t total = 0, unexpected = 0;
+    // 每帧应显示 floor 或 ceil(帧时长 / 垂直同步周期) 个周期
+    int64_t low = FRAME_TIME / stats.vsync_interval, high = (FRAME_TIME + stats.vsync_interval - 1) / stats.vsync_interval;
+    for (int i = 0; i < PLAYER_PACING_HISTOGRAM_SIZE; i++) {
+        player_log(AV_LOG_INFO, "%d vsync(s): %llu frames\n", i, stats.interval_histogram[i]);
+        total += stats.interval_histogram[i];
+        if (i != low && i != high) unexpected += stats.interval_histogram[i];
+    }
+    player_log(AV_LOG_INFO, "Presented frames: %llu, missed vsyncs: %llu, unexpected intervals: %llu\n", stats.presented_frames, stats.missed_vsyncs, unexpected);
+    if (!total || unexpected * 20 > total) return 1;
+    return 0;
+}
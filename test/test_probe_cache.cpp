@@ -0,0 +1,104 @@
+#include <windows.h>
+#include "../player.h"
+#include <string>
+#include "wchar_util.h"
+
+#define ROUNDS 5
+
+// Function to open a file dialog and get the selected file path
+std::string MyGetOpenFileName() {
+    wchar_t path[MAX_PATH] = L"";
+    OPENFILENAMEW ofn;
+    ZeroMemory(&ofn, sizeof(ofn));
+    ofn.lStructSize = sizeof(OPENFILENAMEW);
+    ofn.hwndOwner = NULL;
+    ofn.lpstrFilter = L"All Files (*.*)\0";
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_EXPLORER | OFN_FILEMUSTEXIST | OFN_HIDEREADONLY;
+    ofn.lpstrDefExt = L"";
+
+    if (GetOpenFileNameW(&ofn)) {
+        std::string tmp;
+        if (!wchar_util::wstr_to_str(tmp, ofn.lpstrFile, CP_UTF8)) {
+            return "";
+        }
+        return tmp;
+    }
+
+    return "";
+}
+
+static double elapsed_ms(LARGE_INTEGER start, LARGE_INTEGER freq) {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (double)(now.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart;
+}
+
+/// @brief 创建会话直到初始化完成所需的时间，失败时返回 -1
+static double open_once(const std::string& path, PlayerSettings* settings, LARGE_INTEGER freq) {
+    LARGE_INTEGER start;
+    PlayerSession* ses = nullptr;
+    QueryPerformanceCounter(&start);
+    int re = player_create2(path.c_str(), &ses, settings);
+    if (re != PLAYER_ERR_OK || wait_player_inited(ses)) {
+        player_log(AV_LOG_ERROR, "Failed to create player session: %s\n", player_get_err_msg2(re));
+        player_free(&ses);
+        return -1;
+    }
+    double ms = elapsed_ms(start, freq);
+    player_free(&ses);
+    return ms;
+}
+
+// 比较不使用缓存、首次打开（写入缓存）和再次打开（命中缓存）时创建会话所需的时间
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_probe_cache.log", 0, AV_LOG_VERBOSE);
+    std::string path = MyGetOpenFileName();
+    if (path.empty()) {
+        return 0;
+    }
+    wchar_t temp[MAX_PATH];
+    if (!GetTempPathW(MAX_PATH, temp)) return 1;
+    std::wstring wdir = std::wstring(temp) + L"player_probe_cache_" + std::to_wstring(GetCurrentProcessId());
+    if (!CreateDirectoryW(wdir.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS) return 1;
+    std::string dir;
+    if (!wchar_util::wstr_to_str(dir, wdir.c_str(), CP_UTF8)) return 1;
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    PlayerSettings* settings = player_settings_init();
+    if (!settings) return 1;
+    int result = 1;
+    double uncached_ms = 0, cold_ms = 0, warm_ms = 0, ms;
+    uint64_t hits, misses, base_hits, base_misses;
+    for (int i = 0; i < ROUNDS; i++) {
+        if ((ms = open_once(path, settings, freq)) < 0) goto end;
+        uncached_ms += ms;
+    }
+    if (player_settings_set_probe_cache(settings, dir.c_str())) goto end;
+    player_get_probe_cache_stats(&base_hits, &base_misses);
+    if ((cold_ms = open_once(path, settings, freq)) < 0) goto end;
+    for (int i = 0; i < ROUNDS; i++) {
+        if ((ms = open_once(path, settings, freq)) < 0) goto end;
+        warm_ms += ms;
+    }
+    player_get_probe_cache_stats(&hits, &misses);
+    hits -= base_hits;
+    misses -= base_misses;
+    player_log(AV_LOG_INFO, "No cache: %.2f ms, cold: %.2f ms, warm: %.2f ms (average of %d)\n", uncached_ms / ROUNDS, cold_ms, warm_ms / ROUNDS, ROUNDS);
+    player_log(AV_LOG_INFO, "Probe cache hits: %llu, misses: %llu\n", hits, misses);
+    // 第一次打开未命中，之后每次都应命中
+    if (misses == 1 && hits == ROUNDS) result = 0;
+end:
+    player_settings_free(&settings);
+    WIN32_FIND_DATAW data;
+    HANDLE find = FindFirstFileW((wdir + L"\\*.probe").c_str(), &data);
+    if (find != INVALID_HANDLE_VALUE) {
+        do {
+            DeleteFileW((wdir + L"\\" + data.cFileName).c_str());
+        } while (FindNextFileW(find, &data));
+        FindClose(find);
+    }
+    RemoveDirectoryW(wdir.c_str());
+    return result;
+}
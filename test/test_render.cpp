@@ -0,0 +1,47 @@
+#include <windows.h>
+#include "../player.h"
+#include <string>
+#include "wchar_util.h"
+
+// Function to open a file dialog and get the selected file path
+std::string MyGetOpenFileName() {
+    wchar_t path[MAX_PATH] = L"";
+    OPENFILENAMEW ofn;
+    ZeroMemory(&ofn, sizeof(ofn));
+    ofn.lStructSize = sizeof(OPENFILENAMEW);
+    ofn.hwndOwner = NULL;
+    ofn.lpstrFilter = L"All Files (*.*)\0";
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_EXPLORER | OFN_FILEMUSTEXIST | OFN_HIDEREADONLY;
+    ofn.lpstrDefExt = L"";
+
+    if (GetOpenFileNameW(&ofn)) {
+        std::string tmp;
+        if (!wchar_util::wstr_to_str(tmp, ofn.lpstrFile, CP_UTF8)) {
+            return "";
+        }
+        return tmp;
+    }
+
+    return "";
+}
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_render.log", 0, AV_LOG_VERBOSE);
+    std::string path = MyGetOpenFileName();
+    if (path.empty()) {
+        return 0;
+    }
+    PlayerRenderResult result;
+    int re = player_render_to_file(path.c_str(), NULL, "test_render.wav", "test_render.y4m", &result);
+    if (re != PLAYER_ERR_OK) {
+        char* err = player_get_err_msg(re);
+        player_log(AV_LOG_ERROR, "Failed to render: %s\n", err ? err : "Unknown error");
+        if (err) free(err);
+        return 1;
+    }
+    player_log(AV_LOG_INFO, "Audio samples: %llu, video frames: %llu, duplicated: %llu, dropped: %llu\n", result.audio_samples, result.video_frames, result.duplicated_frames, result.dropped_frames);
+    player_log(AV_LOG_INFO, "Rendered %lld us in %lld us (%.2fx realtime)\n", result.duration, result.elapsed, result.elapsed > 0 ? (double)result.duration / result.elapsed : 0.0);
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <windows.h>
+#include "../player.h"
+#include <string>
+#include "wchar_util.h"
+
+// Function to open a file dialog and get the selected file path
+std::string MyGetOpenFileName() {
+    wchar_t path[MAX_PATH] = L"";
+    OPENFILENAMEW ofn;
+    ZeroMemory(&ofn, sizeof(ofn));
+    ofn.lStructSize = sizeof(OPENFILENAMEW);
+    ofn.hwndOwner = NULL;
+    ofn.lpstrFilter = L"All Files (*.*)\0";
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_EXPLORER | OFN_FILEMUSTEXIST | OFN_HIDEREADONLY;
+    ofn.lpstrDefExt = L"";
+
+    if (GetOpenFileNameW(&ofn)) {
+        std::string tmp;
+        if (!wchar_util::wstr_to_str(tmp, ofn.lpstrFile, CP_UTF8)) {
+            return "";
+        }
+        return tmp;
+    }
+
+    return "";
+}
+
+// 为选择的文件（如 MPEG-TS）建立跳转索引，之后打开时应能获取到时长
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_seek_index.log", 0, AV_LOG_VERBOSE);
+    std::string path = MyGetOpenFileName();
+    if (path.empty()) {
+        return 0;
+    }
+    wchar_t temp[MAX_PATH];
+    if (!GetTempPathW(MAX_PATH, temp)) return 1;
+    std::wstring wdir = std::wstring(temp) + L"player_seek_index_" + std::to_wstring(GetCurrentProcessId());
+    if (!CreateDirectoryW(wdir.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS) return 1;
+    std::string dir;
+    if (!wchar_util::wstr_to_str(dir, wdir.c_str(), CP_UTF8)) return 1;
+    int result = 1;
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    int re = player_build_seek_index(path.c_str(), dir.c_str());
+    QueryPerformanceCounter(&end);
+    if (re) {
+        player_log(AV_LOG_ERROR, "Failed to build seek index: %s\n", player_get_err_msg2(re));
+    } else {
+        player_log(AV_LOG_INFO, "Built seek index in %.2f ms\n", (double)(end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+        PlayerSettings* settings = player_settings_init();
+        PlayerSession* ses = nullptr;
+        int64_t duration = 0;
+        if (settings && !player_settings_set_seek_index(settings, dir.c_str()) && !player_create2(path.c_str(), &ses, settings) && !wait_player_inited(ses)) {
+            if (!(re = player_get_duration(ses, &duration))) {
+                player_log(AV_LOG_INFO, "Duration: %lld us\n", duration);
+                result = 0;
+            } else {
+                player_log(AV_LOG_ERROR, "Failed to get duration: %s\n", player_get_err_msg2(re));
+            }
+        }
+        player_free(&ses);
+        player_settings_free(&settings);
+    }
+    WIN32_FIND_DATAW data;
+    HANDLE find = FindFirstFileW((wdir + L"\\*.pidx").c_str(), &data);
+    if (find != INVALID_HANDLE_VALUE) {
+        do {
+            DeleteFileW((wdir + L"\\" + data.cFileName).c_str());
+        } while (FindNextFileW(find, &data));
+        FindClose(find);
+    }
+    RemoveDirectoryW(wdir.c_str());
+    return result;
+}
@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+#include "../src/sync.h"
+
+// 用虚拟时钟回放音频回调和解码的时间线，检查 video_sync_decide 的丢帧、跳帧和刷新时间
+
+#define VSYNC_60HZ 16667
+#define FRAME_24P 41708
+#define FRAME_60P 16667
+#define LOOKAHEAD 4
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        failures++; \
+        printf("FAILED %s:%d: %s: ", __FILE__, __LINE__, #cond); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+/// @brief 确定性的伪随机数，保证每次运行结果相同
+static uint32_t lcg(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+struct Timeline {
+    /// @brief 第 i 帧的时间（相对于第一帧）
+    std::vector<int64_t> pts;
+    /// @brief 第 i 帧解码完成的时间，超过后才能放入缓冲区
+    std::vector<int64_t> decoded_at;
+    /// @brief 第 i 帧自身的时长，为空时未知
+    std::vector<int64_t> frame_duration;
+    /// @brief 名义帧时长
+    int64_t frame_time = FRAME_24P;
+    int64_t vsync_time = VSYNC_60HZ;
+    /// @brief 音频回调周期和抖动，周期为0时使用系统时钟
+    int64_t audio_period = 0;
+    int64_t audio_jitter = 0;
+    /// @brief 定时器唤醒的最大延迟
+    int64_t timer_jitter = 1000;
+    /// @brief 是否把帧的时间戳交给 video_sync_decide，为0时只能按名义帧时长调度
+    unsigned char use_pts = 1;
+    int64_t duration = 10000000;
+};
+
+struct Result {
+    /// @brief 每个显示的帧第一次出现的垂直同步序号
+    std::vector<int64_t> shown_vsync;
+    /// @brief 每个显示的帧的序号
+    std::vector<int> shown_index;
+    uint64_t dropped = 0;
+    uint64_t underflows = 0;
+    /// @brief 画面出现时播放位置与帧时间的最大偏差（超出该帧显示区间的部分）
+    int64_t max_sync_error = 0;
+    int64_t sync_error_after_recover = 0;
+};
+
+static Result run(const Timeline& t, int64_t recover_time = 0) {
+    Result r;
+    uint32_t seed = 12345;
+    const int64_t start = 1000000;
+    int64_t now = start;
+    int64_t last_vsync = start;
+    int head = 0;
+    unsigned char head_displayed = 0;
+    int64_t video_pts = t.pts[0];
+    // 音频回调：记录交给设备的数据的结束位置
+    int64_t audio_pts = 0, audio_ts = INT64_MIN, next_callback = start;
+    int total = (int)t.pts.size();
+    while (now - start < t.duration && head < total) {
+        int64_t clock;
+        if (t.audio_period) {
+            while (next_callback <= now) {
+                int64_t jitter = t.audio_jitter ? (int64_t)(lcg(&seed) % (uint32_t)t.audio_jitter) : 0;
+                int64_t cb = next_callback + jitter;
+                if (cb > now) break;
+                audio_ts = cb;
+                // 设备缓冲区有一个周期，回调时交出的数据在一个周期后才能听到
+                audio_pts = cb - start + t.audio_period;
+                next_callback += t.audio_period;
+            }
+            clock = video_sync_audio_clock(audio_pts, 0, audio_ts, now, t.audio_period);
+            if (audio_ts == INT64_MIN) clock = 0;
+        } else {
+            clock = now - start;
+        }
+        int available = 0;
+        while (head + available < total && available < LOOKAHEAD && t.decoded_at[head + available] <= now) available++;
+        int64_t frame_pts[VIDEO_SYNC_MAX_FRAMES], frame_duration[VIDEO_SYNC_MAX_FRAMES];
+        for (int i = 0; i < available && i < VIDEO_SYNC_MAX_FRAMES; i++) {
+            frame_pts[i] = t.use_pts ? t.pts[head + i] : INT64_MIN;
+            frame_duration[i] = t.frame_duration.empty() ? 0 : t.frame_duration[head + i];
+        }
+        VideoSyncParams p = {};
+        VideoSyncDecision d;
+        p.clock = clock;
+        p.now = now;
+        p.last_vsync = last_vsync;
+        p.vsync_time = t.vsync_time;
+        p.video_pts = video_pts;
+        p.frame_time = t.frame_time;
+        p.frames = available;
+        p.frame_pts = frame_pts;
+        p.frame_duration = frame_duration;
+        p.frame_pts_count = available;
+        p.eof = head + available >= total;
+        p.head_displayed = head_displayed;
+        video_sync_decide(&p, &d);
+        CHECK(d.advance <= available, "advance=%d available=%d", d.advance, available);
+        CHECK(d.delay >= 0, "delay=%lld", (long long)d.delay);
+        head += d.advance;
+        if (d.advance) head_displayed = 0;
+        video_pts = d.video_pts;
+        r.dropped += d.dropped;
+        if (d.underflow) {
+            r.underflows++;
+        } else if (head < total) {
+            // 开启垂直同步时画面在下一次垂直同步出现
+            last_vsync = d.next_vsync;
+            if (!head_displayed) {
+                head_displayed = 1;
+                r.shown_vsync.push_back((d.next_vsync - start + t.vsync_time / 2) / t.vsync_time);
+                r.shown_index.push_back(head);
+                // 画面出现时播放位置应在该帧的显示区间内（允许半个垂直同步周期的取整）
+                int64_t err = 0, pts = t.pts[head], end = head + 1 < total ? t.pts[head + 1] : pts + t.frame_time;
+                if (d.display_pos < pts - t.vsync_time / 2) err = pts - t.vsync_time / 2 - d.display_pos;
+                else if (d.display_pos > end + t.vsync_time / 2) err = d.display_pos - (end + t.vsync_time / 2);
+                if (err > r.max_sync_error) r.max_sync_error = err;
+                if (recover_time && now - start > recover_time && err > r.sync_error_after_recover) r.sync_error_after_recover = err;
+            }
+        }
+        // SDL 定时器以毫秒为单位，唤醒会有延迟
+        int64_t delay = d.delay / 1000 * 1000;
+        if (t.timer_jitter) delay += lcg(&seed) % (uint32_t)t.timer_jitter;
+        now += delay > 0 ? delay : 1000;
+    }
+    return r;
+}
+
+static Timeline make_cfr(int64_t frame_time, int64_t duration) {
+    Timeline t;
+    t.frame_time = frame_time;
+    t.duration = duration;
+    for (int64_t i = 0; i * frame_time < duration + 1000000; i++) {
+        t.pts.push_back(i * frame_time);
+        t.decoded_at.push_back(0);
+    }
+    return t;
+}
+
+/// @brief 统计相邻显示帧之间的垂直同步间隔
+static std::vector<uint64_t> histogram(const Result& r) {
+    std::vector<uint64_t> h(8, 0);
+    for (size_t i = 1; i < r.shown_vsync.size(); i++) {
+        int64_t n = r.shown_vsync[i] - r.shown_vsync[i - 1];
+        h[n < 0 ? 0 : n > 7 ? 7 : n]++;
+    }
+    return h;
+}
+
+static void test_cadence_24p_on_60hz() {
+    Timeline t = make_cfr(FRAME_24P, 10000000);
+    Result r = run(t);
+    auto h = histogram(r);
+    CHECK(r.dropped == 0, "dropped=%llu", (unsigned long long)r.dropped);
+    CHECK(h[2] + h[3] == r.shown_vsync.size() - 1, "h2=%llu h3=%llu total=%zu", (unsigned long long)h[2], (unsigned long long)h[3], r.shown_vsync.size());
+    // 3:2 交替时两种间隔的数量相差不超过1
+    CHECK(llabs((long long)h[2] - (long long)h[3]) <= 1, "h2=%llu h3=%llu", (unsigned long long)h[2], (unsigned long long)h[3]);
+    CHECK(r.max_sync_error == 0, "max_sync_error=%lld", (long long)r.max_sync_error);
+}
+
+static void test_60p_on_60hz() {
+    Timeline t = make_cfr(FRAME_60P, 5000000);
+    Result r = run(t);
+    auto h = histogram(r);
+    CHECK(r.dropped == 0, "dropped=%llu", (unsigned long long)r.dropped);
+    CHECK(h[1] == r.shown_vsync.size() - 1, "h1=%llu total=%zu", (unsigned long long)h[1], r.shown_vsync.size());
+}
+
+static void test_jittery_audio_clock() {
+    Timeline t = make_cfr(FRAME_24P, 10000000);
+    t.audio_period = 10000;
+    t.audio_jitter = 4000;
+    Result r = run(t);
+    auto h = histogram(r);
+    uint64_t total = r.shown_vsync.size() - 1;
+    CHECK(r.dropped == 0, "dropped=%llu", (unsigned long long)r.dropped);
+    // 音频回调抖动小于半个垂直同步周期，节奏基本不受影响
+    CHECK((h[2] + h[3]) * 100 >= total * 95, "h2=%llu h3=%llu total=%llu", (unsigned long long)h[2], (unsigned long long)h[3], (unsigned long long)total);
+    CHECK(r.max_sync_error <= t.audio_jitter, "max_sync_error=%lld", (long long)r.max_sync_error);
+}
+
+static void test_decoder_stall() {
+    Timeline t = make_cfr(FRAME_24P, 5000000);
+    // 1s 到 1.3s 之间解码卡住，之后一次性补上
+    for (size_t i = 0; i < t.pts.size(); i++) {
+        int64_t ready = t.pts[i] - 200000;
+        if (ready > 1000000 + 1000000 && ready < 1000000 + 1300000) ready = 1000000 + 1300000;
+        t.decoded_at[i] = ready + 1000000;
+    }
+    Result r = run(t, 2000000);
+    CHECK(r.underflows > 0, "underflows=%llu", (unsigned long long)r.underflows);
+    CHECK(r.dropped > 0, "dropped=%llu", (unsigned long long)r.dropped);
+    // 落后的帧被丢弃，恢复后重新同步
+    CHECK(r.sync_error_after_recover == 0, "sync_error_after_recover=%lld", (long long)r.sync_error_after_recover);
+}
+
+static void test_vfr_resync() {
+    Timeline t;
+    t.duration = 5000000;
+    // 帧时长在 33ms 和 50ms 之间变化，按 33ms 的名义帧时长调度
+    int64_t pts = 0;
+    for (int i = 0; pts < t.duration + 1000000; i++) {
+        t.pts.push_back(pts);
+        t.decoded_at.push_back(0);
+        pts += (i / 10) % 2 ? 50000 : 33333;
+    }
+    t.frame_time = 33333;
+    Result r = run(t);
+    // 按帧的时间戳调度，每次显示的帧都与播放位置同步
+    CHECK(r.max_sync_error == 0, "max_sync_error=%lld", (long long)r.max_sync_error);
+    for (size_t i = 1; i < r.shown_index.size(); i++) {
+        CHECK(r.shown_index[i] > r.shown_index[i - 1], "index %d after %d", r.shown_index[i], r.shown_index[i - 1]);
+    }
+}
+
+/**
+ * @brief 与理想显示方式（每个垂直同步显示离其最近的帧）比较，统计丢弃和多显示的帧
+ * @param duplicated 用于接收比理想情况多显示的垂直同步数
+ * @return 理想情况下应显示但没有显示的帧数
+*/
+static uint64_t compare_with_ideal(const Timeline& t, const Result& r, uint64_t* duplicated) {
+    uint64_t dropped = 0;
+    *duplicated = 0;
+    for (size_t i = 0; i + 1 < r.shown_index.size(); i++) {
+        int index = r.shown_index[i];
+        // 帧应显示的垂直同步数
+        int64_t ideal = (t.pts[index + 1] + t.vsync_time / 2) / t.vsync_time - (t.pts[index] + t.vsync_time / 2) / t.vsync_time;
+        int64_t actual = r.shown_vsync[i + 1] - r.shown_vsync[i];
+        if (actual > ideal) *duplicated += actual - ideal;
+        for (int j = index + 1; j < r.shown_index[i + 1]; j++) {
+            if ((t.pts[j + 1] + t.vsync_time / 2) / t.vsync_time > (t.pts[j] + t.vsync_time / 2) / t.vsync_time) dropped++;
+        }
+    }
+    return dropped;
+}
+
+static void test_vfr_frame_durations() {
+    // 手机录制的可变帧率视频：名义 30 fps，画面静止时降到 20 fps，运动时升到 60 fps
+    Timeline t;
+    t.duration = 10000000;
+    t.frame_time = 33333;
+    const int64_t intervals[] = { 33333, 33333, 50000, 50000, 16667, 16667, 16667, 33333 };
+    int64_t pts = 0;
+    for (int i = 0; pts < t.duration + 1000000; i++) {
+        int64_t interval = intervals[(i / 7) % 8];
+        t.pts.push_back(pts);
+        t.frame_duration.push_back(interval);
+        t.decoded_at.push_back(0);
+        pts += interval;
+    }
+    uint64_t duplicated = 0;
+    Result r = run(t);
+    uint64_t dropped = compare_with_ideal(t, r, &duplicated);
+    printf("VFR with timestamps: shown=%zu, dropped=%llu, duplicated=%llu, max_sync_error=%lld\n", r.shown_index.size(), (unsigned long long)dropped, (unsigned long long)duplicated, (long long)r.max_sync_error);
+    CHECK(dropped == 0, "dropped=%llu", (unsigned long long)dropped);
+    CHECK(duplicated == 0, "duplicated=%llu", (unsigned long long)duplicated);
+    CHECK(r.max_sync_error == 0, "max_sync_error=%lld", (long long)r.max_sync_error);
+    // 没有时间戳时使用帧自身的时长，结果相同
+    t.use_pts = 0;
+    Result r2 = run(t);
+    dropped = compare_with_ideal(t, r2, &duplicated);
+    printf("VFR with durations: shown=%zu, dropped=%llu, duplicated=%llu, max_sync_error=%lld\n", r2.shown_index.size(), (unsigned long long)dropped, (unsigned long long)duplicated, (long long)r2.max_sync_error);
+    CHECK(dropped == 0 && duplicated == 0, "dropped=%llu duplicated=%llu", (unsigned long long)dropped, (unsigned long long)duplicated);
+    CHECK(r2.max_sync_error == 0, "max_sync_error=%lld", (long long)r2.max_sync_error);
+    // 两者都没有时只能按名义帧时长调度，显示节奏与帧的时间不符，并逐渐偏离播放位置
+    t.frame_duration.clear();
+    Result r3 = run(t);
+    dropped = compare_with_ideal(t, r3, &duplicated);
+    printf("VFR with nominal frame rate: shown=%zu, dropped=%llu, duplicated=%llu, max_sync_error=%lld\n", r3.shown_index.size(), (unsigned long long)dropped, (unsigned long long)duplicated, (long long)r3.max_sync_error);
+    CHECK(dropped + duplicated > 0, "dropped=%llu duplicated=%llu", (unsigned long long)dropped, (unsigned long long)duplicated);
+    CHECK(r3.max_sync_error > 0, "max_sync_error=%lld", (long long)r3.max_sync_error);
+}
+
+int main() {
+    test_cadence_24p_on_60hz();
+    test_60p_on_60hz();
+    test_jittery_audio_clock();
+    test_decoder_stall();
+    test_vfr_resync();
+    test_vfr_frame_durations();
+    if (failures) {
+        printf("%d check(s) failed.\n", failures);
+        return 1;
+    }
+    printf("All checks passed.\n");
+    return 0;
+}
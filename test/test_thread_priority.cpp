@@ -0,0 +1,38 @@
+#include <windows.h>
+#include "../player.h"
+
+// 提高解码和事件线程的优先级并绑定到第一个 CPU，检查实际应用的设置
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_thread_priority.log", 0, AV_LOG_VERBOSE);
+    PlayerSettings* settings = player_settings_init();
+    if (!settings) return 1;
+    player_settings_set_thread_priority(settings, PLAYER_THREAD_DECODE, PLAYER_THREAD_PRIORITY_REALTIME);
+    player_settings_set_thread_priority(settings, PLAYER_THREAD_EVENT, PLAYER_THREAD_PRIORITY_HIGH);
+    player_settings_set_thread_affinity(settings, PLAYER_THREAD_DECODE, 1);
+    if (player_settings_set_input_format(settings, "lavfi")) {
+        player_settings_free(&settings);
+        return 1;
+    }
+    PlayerSession* ses = nullptr;
+    int re = player_create2("testsrc=size=640x360:rate=30", &ses, settings);
+    if (re != PLAYER_ERR_OK || wait_player_inited(ses)) {
+        player_log(AV_LOG_ERROR, "Failed to create player session: %s\n", player_get_err_msg2(re));
+        player_free(&ses);
+        player_settings_free(&settings);
+        return 1;
+    }
+    player_wait_until_buffer_is_full(ses);
+    player_play(ses);
+    Sleep(1000);
+    int result = 0;
+    for (int i = 0; i < PLAYER_THREAD_COUNT; i++) {
+        PlayerThreadInfo info;
+        player_get_thread_info(ses, i, &info);
+        player_log(AV_LOG_INFO, "Thread %d: priority %d -> %d (system %d), affinity 0x%llx -> 0x%llx, NUMA node %d, error %lu\n", i, info.requested_priority, info.applied_priority, info.os_priority, info.requested_affinity, info.applied_affinity, info.numa_node, info.error);
+        // 没有权限时可以降级，但不应完全没有提高优先级
+        if (info.applied_priority == PLAYER_THREAD_PRIORITY_DEFAULT) result = 1;
+    }
+    player_free(&ses);
+    player_settings_free(&settings);
+    return result;
+}
@@ -0,0 +1,61 @@
+#include <windows.h>
+#include "../player.h"
+#include <string>
+#include <vector>
+#include "wchar_util.h"
+
+#define THUMBNAIL_COUNT 20
+#define BATCH_COPIES 8
+
+// Function to open a file dialog and get the selected file path
+std::string MyGetOpenFileName() {
+    wchar_t path[MAX_PATH] = L"";
+    OPENFILENAMEW ofn;
+    ZeroMemory(&ofn, sizeof(ofn));
+    ofn.lStructSize = sizeof(OPENFILENAMEW);
+    ofn.hwndOwner = NULL;
+    ofn.lpstrFilter = L"All Files (*.*)\0";
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_EXPLORER | OFN_FILEMUSTEXIST | OFN_HIDEREADONLY;
+    ofn.lpstrDefExt = L"";
+
+    if (GetOpenFileNameW(&ofn)) {
+        std::string tmp;
+        if (!wchar_util::wstr_to_str(tmp, ofn.lpstrFile, CP_UTF8)) {
+            return "";
+        }
+        return tmp;
+    }
+
+    return "";
+}
+
+int on_thumbnail(void* userdata, const char* url, int index, int64_t pts, const uint8_t* rgba, int linesize, int width, int height) {
+    InterlockedIncrement((volatile LONG*)userdata);
+    return 0;
+}
+
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_thumbnails.log", 0, AV_LOG_VERBOSE);
+    std::string path = MyGetOpenFileName();
+    if (path.empty()) {
+        return 0;
+    }
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
+    volatile LONG got = 0;
+    QueryPerformanceCounter(&start);
+    int re = player_extract_thumbnails(path.c_str(), THUMBNAIL_COUNT, 160, -1, on_thumbnail, (void*)&got);
+    QueryPerformanceCounter(&end);
+    double elapsed = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    player_log(AV_LOG_INFO, "Single: %s, %ld thumbnails in %.3f s (%.1f thumbnails/s)\n", player_get_err_msg2(re), got, elapsed, elapsed > 0 ? got / elapsed : 0.0);
+    std::vector<const char*> urls(BATCH_COPIES, path.c_str());
+    got = 0;
+    QueryPerformanceCounter(&start);
+    re = player_extract_thumbnails_batch(urls.data(), (int)urls.size(), THUMBNAIL_COUNT, 160, -1, on_thumbnail, (void*)&got, 0);
+    QueryPerformanceCounter(&end);
+    elapsed = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    player_log(AV_LOG_INFO, "Batch: %s, %ld thumbnails in %.3f s (%.1f thumbnails/s)\n", player_get_err_msg2(re), got, elapsed, elapsed > 0 ? got / elapsed : 0.0);
+    return 0;
+}
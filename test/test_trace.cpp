@@ -0,0 +1,50 @@
+#include <windows.h>
+#include "../player.h"
+#include <stdio.h>
+#include <string>
+
+// 记录播放 2 秒的各步骤耗时并导出，生成的 test_trace.json 可以在 ui.perfetto.dev 中打开
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    set_player_log_file("test_trace.log", 0, AV_LOG_VERBOSE);
+    PlayerSettings* settings = player_settings_init();
+    if (!settings) return 1;
+    if (player_settings_set_input_format(settings, "lavfi")) {
+        player_settings_free(&settings);
+        return 1;
+    }
+    player_trace_start();
+    PlayerSession* ses = nullptr;
+    int re = player_create2("testsrc=size=640x360:rate=30", &ses, settings);
+    if (re != PLAYER_ERR_OK || wait_player_inited(ses)) {
+        player_log(AV_LOG_ERROR, "Failed to create player session: %s\n", player_get_err_msg2(re));
+        player_free(&ses);
+        player_settings_free(&settings);
+        return 1;
+    }
+    player_wait_until_buffer_is_full(ses);
+    player_play(ses);
+    Sleep(2000);
+    player_trace_stop();
+    player_free(&ses);
+    player_settings_free(&settings);
+    if ((re = player_trace_dump("test_trace.json"))) {
+        player_log(AV_LOG_ERROR, "Failed to dump trace: %s\n", player_get_err_msg2(re));
+        return 1;
+    }
+    FILE* f = fopen("test_trace.json", "rb");
+    if (!f) return 1;
+    std::string data;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.append(buf, n);
+    fclose(f);
+    // 至少应包含读取、解码和显示的记录
+    const char* names[] = { "\"av_read_frame\"", "\"avcodec_receive_frame (video)\"", "\"present\"" };
+    for (const char* name : names) {
+        if (data.find(name) == std::string::npos) {
+            player_log(AV_LOG_ERROR, "Missing %s in trace.\n", name);
+            return 1;
+        }
+    }
+    return 0;
+}